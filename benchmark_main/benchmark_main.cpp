@@ -0,0 +1,459 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <list>
+#include <limits>
+#include <random>
+#include <atomic>
+#include <functional>
+#include <new>
+
+using namespace std;
+
+#include "../item/item.hpp"
+#include "../point/point.hpp"
+#include "../curve/curve.hpp"
+#include "../Tuple/tuple.hpp"
+#include "../dataset/dataset.hpp"
+#include "../distance/distance.hpp"
+#include "../hash_engine/hash_engine.hpp"
+#include "../query_result/query_result.hpp"
+#include "../helping_functions/helping_functions.hpp"
+#include "../lsh/lsh.hpp"
+#include "../hypercube/hypercube.hpp"
+
+#define ITEMS_DEFAULT 10000
+#define DIMENSION_DEFAULT 128
+#define QUERIES_DEFAULT 100
+#define CURVE_LENGTH_DEFAULT 50
+#define TRAVERSAL_LENGTH_DEFAULT 8
+#define MIN_TIME_DEFAULT 0.2
+#define SEED_DEFAULT 1
+#define COORDINATE_MAX 10000
+
+//the parameters of the mains
+#define L_DEFAULT 5
+#define K_DEFAULT 4
+#define W_DEFAULT 4300
+#define CUBE_W_DEFAULT 4000
+#define CUBE_M_DEFAULT 5000
+#define CUBE_PROBES_DEFAULT 14
+#define GRID_DELTA_DEFAULT 0.5
+#define PROJECTION_K_DEFAULT 4
+
+//every operator new of the process is counted, an op that allocates shows up
+//in allocations_per_op without a profiler
+static atomic<uint64_t> allocations(0);
+static atomic<uint64_t> allocated_bytes(0);
+
+void* operator new(size_t size) {
+	allocations.fetch_add(1, memory_order_relaxed);
+	allocated_bytes.fetch_add(size, memory_order_relaxed);
+	void *pointer = malloc(size == 0 ? 1 : size);
+	if (pointer == NULL) {
+		throw bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+//the replaced operator new above allocates with malloc, so free is the matching release
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+	free(pointer);
+}
+#pragma GCC diagnostic pop
+
+//keeps the results of the ops alive, so the compiler can not drop the calls
+static volatile double sink;
+
+struct Benchmark_Result {
+	string name;
+	uint64_t iterations;
+	double ns_per_op;
+	double ops_per_second;
+	double bytes_per_second; //0 when the op has no natural input size
+	double allocations_per_op;
+	double allocated_bytes_per_op;
+};
+
+//calls op(0), op(1), ... until a run lasts min_time seconds. The number of
+//iterations grows from one by the measured rate, so slow ops run few times
+static Benchmark_Result run_benchmark(const string& name, size_t bytes_per_op, double min_time,
+		const function<void(uint64_t)>& op) {
+	Benchmark_Result result;
+	uint64_t iterations = 1;
+	double time;
+	uint64_t start_allocations, start_bytes;
+
+	op(0);
+	while (true) {
+		start_allocations = allocations.load();
+		start_bytes = allocated_bytes.load();
+		time = get_wall_time();
+		for (uint64_t i = 0; i < iterations; i++) {
+			op(i);
+		}
+		time = get_wall_time() - time;
+		if (time >= min_time) {
+			break;
+		}
+		double growth = time <= 0 ? 100 : 1.4*min_time/time;
+		iterations = max(iterations + 1, (uint64_t)(iterations*min(growth, 100.0)));
+	}
+
+	result.name = name;
+	result.iterations = iterations;
+	result.ns_per_op = time*1e9/iterations;
+	result.ops_per_second = iterations/time;
+	result.bytes_per_second = bytes_per_op*result.ops_per_second;
+	result.allocations_per_op = (double)(allocations.load() - start_allocations)/iterations;
+	result.allocated_bytes_per_op = (double)(allocated_bytes.load() - start_bytes)/iterations;
+	return result;
+}
+
+static void print_json(FILE *out, vector<Benchmark_Result>& results, uint32_t items, int dimension,
+		int queries, int curve_length, int traversal_length, unsigned seed) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"items\": %u,\n", items);
+	fprintf(out, "  \"dimension\": %d,\n", dimension);
+	fprintf(out, "  \"queries\": %d,\n", queries);
+	fprintf(out, "  \"curve_length\": %d,\n", curve_length);
+	fprintf(out, "  \"traversal_length\": %d,\n", traversal_length);
+	fprintf(out, "  \"seed\": %u,\n", seed);
+	fprintf(out, "  \"distance_kernel\": \"%s\",\n", get_distance_kernel_name<Type>());
+	fprintf(out, "  \"distance_kernel_float\": \"%s\",\n", get_distance_kernel_name<float>());
+	fprintf(out, "  \"distance_kernel_int16\": \"%s\",\n", get_distance_kernel_name<int16_t>());
+	fprintf(out, "  \"distance_kernel_uint8\": \"%s\",\n", get_distance_kernel_name<uint8_t>());
+	fprintf(out, "  \"dtw_kernel\": \"%s\",\n", get_dtw_kernel_name());
+	fprintf(out, "  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		Benchmark_Result& result = results[i];
+		fprintf(out, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, "
+			"\"ops_per_second\": %.3f, \"bytes_per_second\": %.3f, \"allocations_per_op\": %.3f, "
+			"\"allocated_bytes_per_op\": %.3f}%s\n",
+			result.name.c_str(), (unsigned long long)result.iterations, result.ns_per_op,
+			result.ops_per_second, result.bytes_per_second, result.allocations_per_op,
+			result.allocated_bytes_per_op, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(out, "  ]\n");
+	fprintf(out, "}\n");
+}
+
+static Curve* random_curve(mt19937& generator, int length) {
+	uniform_real_distribution<double> coordinate(0, 100);
+	Curve *curve = new Curve(length);
+	for (int i = 0; i < length; i++) {
+		Type x = coordinate(generator);
+		curve->insert_point(x, coordinate(generator));
+	}
+	return curve;
+}
+
+//the rows of items as T, multiplied by scale to fill the range of the integer types
+template <typename T> static void convert_dataset(Dataset<Type>& items, Dataset<T>& converted, double scale) {
+	int dimension = items.get_dimension();
+	vector<T> row(dimension);
+
+	converted.reserve(items.get_size());
+	for (uint32_t id = 0; id < items.get_size(); id++) {
+		const Type *x = items.get_coordinates(id);
+		for (int i = 0; i < dimension; i++) {
+			row[i] = to_element<T>(x[i]*scale);
+		}
+		converted.insert(items.get_name(id), row.data(), dimension);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	uint32_t num_of_items = ITEMS_DEFAULT;
+	int dimension = DIMENSION_DEFAULT;
+	int num_of_queries = QUERIES_DEFAULT;
+	int curve_length = CURVE_LENGTH_DEFAULT;
+	int traversal_length = TRAVERSAL_LENGTH_DEFAULT;
+	double min_time = MIN_TIME_DEFAULT;
+	unsigned seed = SEED_DEFAULT;
+	string output_file = "", filter = "";
+
+	//READ COMMAND LINE ARGUMENTS
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			num_of_items = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			dimension = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+			num_of_queries = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-curve_length") == 0 && i + 1 < argc) {
+			curve_length = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-traversal_length") == 0 && i + 1 < argc) {
+			traversal_length = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-min_time") == 0 && i + 1 < argc) {
+			min_time = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+			seed = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output_file = argv[++i];
+		}
+		else {
+			cout <<"usage: ./benchmark [-n <items>] [-d <dimension>] [-q <queries>] [-curve_length <int>]"
+				<<" [-traversal_length <int>] [-min_time <seconds>] [-seed <int>] [-filter <name part>]"
+				<<" [-o <json file>]"<<endl;
+			return 1;
+		}
+	}
+	if (num_of_items == 0 || dimension <= 0 || num_of_queries <= 0 || curve_length <= 0
+			|| traversal_length <= 0) {
+		cout <<"The sizes of the synthetic data must be positive"<<endl;
+		return 1;
+	}
+
+	//SYNTHETIC VECTORS AND CURVES
+	mt19937 generator(seed);
+	uniform_real_distribution<double> coordinate(0, COORDINATE_MAX);
+	vector<Type> row(dimension);
+	Dataset<Type> input_items, query_items;
+	input_items.reserve(num_of_items);
+	for (uint32_t id = 0; id < num_of_items; id++) {
+		for (int i = 0; i < dimension; i++) {
+			row[i] = coordinate(generator);
+		}
+		input_items.insert("item" + to_string(id), row.data(), dimension);
+	}
+	for (int id = 0; id < num_of_queries; id++) {
+		for (int i = 0; i < dimension; i++) {
+			row[i] = coordinate(generator);
+		}
+		query_items.insert("query" + to_string(id), row.data(), dimension);
+	}
+	Dataset<float> float_input_items, float_query_items;
+	Dataset<int16_t> int16_input_items, int16_query_items;
+	Dataset<uint8_t> uint8_input_items, uint8_query_items;
+	convert_dataset(input_items, float_input_items, 1);
+	convert_dataset(query_items, float_query_items, 1);
+	convert_dataset(input_items, int16_input_items, 32767.0/COORDINATE_MAX);
+	convert_dataset(query_items, int16_query_items, 32767.0/COORDINATE_MAX);
+	convert_dataset(input_items, uint8_input_items, 255.0/COORDINATE_MAX);
+	convert_dataset(query_items, uint8_query_items, 255.0/COORDINATE_MAX);
+	vector<Curve*> curves;
+	for (int i = 0; i < num_of_queries + 1; i++) {
+		curves.push_back(random_curve(generator, curve_length));
+	}
+
+	//THE HASH FUNCTIONS OF LSH, AS THE MAINS SET THEM UP
+	unsigned m = numeric_limits<unsigned>::max() + 1 - 5;
+	int bits_of_each_hash = 32/K_DEFAULT;
+	unsigned M = 1u << bits_of_each_hash;
+	vector<unsigned> m_powers;
+	for (int i = 0; i < dimension; i++) {
+		m_powers.push_back(pow_mod(m, i, M));
+	}
+	vector<vector<float>*> s_array;
+	for (int i = 0; i < K_DEFAULT; i++) {
+		vector<float> *s = new vector<float>;
+		random_float_vector(0, W_DEFAULT, *s, dimension);
+		s_array.push_back(s);
+	}
+	Hash_Engine hash_engine(L_DEFAULT, dimension, W_DEFAULT, K_DEFAULT, M, m);
+	for (int g = 0; g < L_DEFAULT; g++) {
+		hash_engine.set_s_array(g, s_array);
+	}
+	int cube_bits = max(1, (int)log2(num_of_items));
+	vector<uint64_t> f_seeds;
+	for (int f = 0; f < cube_bits; f++) {
+		f_seeds.push_back(random_f_seed());
+	}
+
+	//THE INPUTS OF THE CURVE CONVERSIONS
+	Point t(0.25, 0.75);
+	double max_coord = 100;
+	int grid_dimension = 2*curve_length;
+	list<vector<Tuple*>*> traversals;
+	find_relevant_traversals(traversal_length, traversal_length, traversals);
+	vector<Tuple*>& traversal = *traversals.front();
+	double **G_matrix = new double*[PROJECTION_K_DEFAULT];
+	for (int i = 0; i < PROJECTION_K_DEFAULT; i++) {
+		G_matrix[i] = new double[2];
+	}
+	random_matrix(PROJECTION_K_DEFAULT, 2, G_matrix, 0, 1);
+
+	//THE INDEXES
+	double time = get_wall_time();
+	LSH<Type> lsh(L_DEFAULT, &input_items, W_DEFAULT, K_DEFAULT, m);
+	lsh.build(1);
+	fprintf(stderr, "LSH build time: %f\n", get_wall_time() - time);
+	time = get_wall_time();
+	Hypercube<Type> hypercube(1, cube_bits, &input_items, CUBE_W_DEFAULT, K_DEFAULT, m, CUBE_M_DEFAULT);
+	for (uint32_t id = 0; id < num_of_items; id++) {
+		hypercube.insert_item(id);
+	}
+	hypercube.freeze();
+	fprintf(stderr, "Hypercube build time: %f\n", get_wall_time() - time);
+	unsigned search_threshold = max(num_of_items/10, (uint32_t)L_DEFAULT*100);
+
+	//THE BENCHMARKS, op(i) works on query i modulo the number of queries
+	size_t vector_bytes = dimension*sizeof(Type);
+	size_t curve_bytes = curve_length*2*sizeof(Type);
+	vector<pair<string, pair<size_t, function<void(uint64_t)>>>> benchmarks;
+	auto add = [&](const string& name, size_t bytes_per_op, function<void(uint64_t)> op) {
+		benchmarks.push_back(make_pair(name, make_pair(bytes_per_op, op)));
+	};
+	auto query = [&](uint64_t i) {return query_items.get_coordinates(i%num_of_queries);};
+
+	add("hash_function", vector_bytes, [&](uint64_t i) {
+		sink = sink + hash_function(query(i), dimension, W_DEFAULT, M, *s_array[0], m_powers);
+	});
+	add("g_hash_function", vector_bytes, [&](uint64_t i) {
+		sink = sink + g_hash_function(query(i), dimension, W_DEFAULT, K_DEFAULT, bits_of_each_hash,
+			M, s_array, m_powers);
+	});
+	add("hash_engine_g_hash", vector_bytes, [&](uint64_t i) {
+		unsigned g_values[L_DEFAULT];
+		hash_engine.g_hash(query(i), g_values);
+		sink = sink + g_values[0];
+	});
+	add("f_hash_function", vector_bytes, [&](uint64_t i) {
+		sink = sink + f_hash_function(query(i), dimension, W_DEFAULT, K_DEFAULT, bits_of_each_hash,
+			M, m_powers, s_array, f_seeds[i%cube_bits]);
+	});
+	add("manhattan_distance", 2*vector_bytes, [&](uint64_t i) {
+		sink = sink + manhattan_distance(query(i), input_items.get_coordinates(i%num_of_items), dimension);
+	});
+	add("manhattan_distance_threshold", 2*vector_bytes, [&](uint64_t i) {
+		sink = sink + manhattan_distance(query(i), input_items.get_coordinates(i%num_of_items), dimension,
+			COORDINATE_MAX*dimension/8.0);
+	});
+	add("manhattan_distance_float", 2*dimension*sizeof(float), [&](uint64_t i) {
+		sink = sink + manhattan_distance(float_query_items.get_coordinates(i%num_of_queries),
+			float_input_items.get_coordinates(i%num_of_items), dimension, numeric_limits<double>::infinity());
+	});
+	add("manhattan_distance_int16", 2*dimension*sizeof(int16_t), [&](uint64_t i) {
+		sink = sink + manhattan_distance(int16_query_items.get_coordinates(i%num_of_queries),
+			int16_input_items.get_coordinates(i%num_of_items), dimension, numeric_limits<double>::infinity());
+	});
+	add("manhattan_distance_uint8", 2*dimension*sizeof(uint8_t), [&](uint64_t i) {
+		sink = sink + manhattan_distance(uint8_query_items.get_coordinates(i%num_of_queries),
+			uint8_input_items.get_coordinates(i%num_of_items), dimension, numeric_limits<double>::infinity());
+	});
+	add("DTW", 2*curve_bytes, [&](uint64_t i) {
+		sink = sink + DTW(curves[i%num_of_queries], curves[num_of_queries]);
+	});
+	add("snap_curve", curve_bytes, [&](uint64_t i) {
+		Curve *grid_curve;
+		snap_curve(curves[i%num_of_queries], &t, &grid_curve, GRID_DELTA_DEFAULT);
+		sink = sink + grid_curve->get_length();
+		delete grid_curve;
+	});
+	add("convert_2d_curve_to_vector", curve_bytes, [&](uint64_t i) {
+		Curve *grid_curve;
+		Item *item;
+		convert_2d_curve_to_vector(curves[i%num_of_queries], &t, GRID_DELTA_DEFAULT, grid_dimension, 2,
+			&grid_curve, &item, max_coord);
+		sink = sink + item->get_coordinates()->size();
+		delete grid_curve;
+		delete item;
+	});
+	add("convert_2d_curve_to_vector_by_projection", curve_bytes, [&](uint64_t i) {
+		Item *item;
+		convert_2d_curve_to_vector_by_projection(traversal, 1, G_matrix, curves[i%num_of_queries],
+			PROJECTION_K_DEFAULT, 2, &item);
+		sink = sink + item->get_coordinates()->size();
+		delete item;
+	});
+	add("find_relevant_traversals", 0, [&](uint64_t i) {
+		list<vector<Tuple*>*> found;
+		find_relevant_traversals(traversal_length, traversal_length, found);
+		sink = sink + found.size();
+		for (vector<Tuple*> *path : found) {
+			for (Tuple *tuple : *path) {
+				delete tuple;
+			}
+			delete path;
+		}
+	});
+	add("LSH::ANN", 0, [&](uint64_t i) {
+		Query_Result result;
+		lsh.ANN(query(i), search_threshold, 0, result);
+		sink = sink + result.get_best_distance();
+	});
+	add("Hypercube::ANN", 0, [&](uint64_t i) {
+		Query_Result result;
+		hypercube.ANN(query(i), CUBE_PROBES_DEFAULT, result);
+		sink = sink + result.get_best_distance();
+	});
+
+	//RUN THE BENCHMARKS
+	vector<Benchmark_Result> results;
+	for (auto& benchmark : benchmarks) {
+		if (filter != "" && benchmark.first.find(filter) == string::npos) {
+			continue;
+		}
+		results.push_back(run_benchmark(benchmark.first, benchmark.second.first, min_time,
+			benchmark.second.second));
+		Benchmark_Result& result = results.back();
+		fprintf(stderr, "%-42s %12.1f ns/op %14.1f ops/s %10.2f allocs/op\n", result.name.c_str(),
+			result.ns_per_op, result.ops_per_second, result.allocations_per_op);
+	}
+
+	//WRITE THE JSON REPORT
+	FILE *out = stdout;
+	if (output_file != "") {
+		out = fopen(output_file.c_str(), "w");
+		if (out == NULL) {
+			cout <<"Output file opening error: "<<output_file<<endl;
+			return 1;
+		}
+	}
+	print_json(out, results, num_of_items, dimension, num_of_queries, curve_length, traversal_length, seed);
+	if (out != stdout) {
+		fclose(out);
+	}
+
+	//FREE THE MEMORY
+	for (vector<float> *s : s_array) {
+		delete s;
+	}
+	for (vector<Tuple*> *path : traversals) {
+		for (Tuple *tuple : *path) {
+			delete tuple;
+		}
+		delete path;
+	}
+	for (int i = 0; i < PROJECTION_K_DEFAULT; i++) {
+		delete[] G_matrix[i];
+	}
+	delete[] G_matrix;
+	for (Curve *curve : curves) {
+		delete curve;
+	}
+	return 0;
+}
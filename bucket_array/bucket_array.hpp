@@ -0,0 +1,53 @@
+#ifndef BUCKET_ARRAY_H
+#define BUCKET_ARRAY_H
+
+#include <vector>
+#include <cstdint>
+
+#include "../index_file/index_file.hpp"
+
+using namespace std;
+
+//dense buckets keep an offset for every key below 2^key_bits, so they are for small key
+//spaces only: 2^24 keys take 64MB of offsets
+#define BUCKET_ARRAY_MAX_KEY_BITS 24
+
+//the frozen buckets of a hash table: the ids of keys[i] are ids[offsets[i] .. offsets[i+1]).
+//Dense buckets have no keys, the ids of key are ids[offsets[key] .. offsets[key+1]).
+//The arrays are either built in memory or used in place from a mapped index file.
+class Bucket_Array {
+public:
+	Bucket_Array();
+
+	void build(vector<pair<unsigned, uint32_t>>& entries);
+	//every key of the entries is below 2^key_bits, key_bits at most BUCKET_ARRAY_MAX_KEY_BITS
+	void build_dense(vector<pair<unsigned, uint32_t>>& entries, int key_bits);
+	bool get_bucket(unsigned key, const uint32_t **begin, const uint32_t **end) const;
+	void save(Index_Writer& writer) const;
+	//fails unless the offsets are sorted and the ids are of the num_of_items items indexed
+	bool load(Index_Reader& reader, uint32_t num_of_items);
+	void print() const;
+	//the number of non empty buckets, their mean and max number of ids and the mean size
+	//of the bucket of an id, what a query that lands where the ids are pays on average
+	void print_loads() const;
+	uint32_t get_num_of_buckets() const {return num_of_buckets;}
+	uint32_t get_num_of_ids() const {return num_of_ids;}
+	bool is_dense() const {return key_bits >= 0;}
+private:
+	Bucket_Array(const Bucket_Array&);
+	Bucket_Array& operator=(const Bucket_Array&);
+
+	void point_to_storage();
+
+	vector<unsigned> key_storage;
+	vector<uint32_t> offset_storage;
+	vector<uint32_t> id_storage;
+	const unsigned *keys;
+	const uint32_t *offsets;
+	const uint32_t *ids;
+	uint32_t num_of_buckets;
+	uint32_t num_of_ids;
+	int key_bits; //-1 when the keys are sparse
+};
+
+#endif
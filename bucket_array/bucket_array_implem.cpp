@@ -0,0 +1,160 @@
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+#include "../index_file/index_file.hpp"
+#include "bucket_array.hpp"
+
+Bucket_Array::Bucket_Array() {
+	this->offset_storage.push_back(0);
+	this->key_bits = -1;
+	point_to_storage();
+}
+
+void Bucket_Array::point_to_storage() {
+	keys = key_storage.data();
+	offsets = offset_storage.data();
+	ids = id_storage.data();
+	num_of_buckets = offset_storage.size() - 1;
+	num_of_ids = id_storage.size();
+}
+
+//sorts the (key, id) pairs, so inside a bucket the ids walk the dataset forward
+void Bucket_Array::build(vector<pair<unsigned, uint32_t>>& entries) {
+	sort(entries.begin(), entries.end());
+
+	key_storage.clear();
+	offset_storage.clear();
+	id_storage.clear();
+	id_storage.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (i == 0 || entries[i].first != entries[i - 1].first) {
+			key_storage.push_back(entries[i].first);
+			offset_storage.push_back(i);
+		}
+		id_storage.push_back(entries[i].second);
+	}
+	offset_storage.push_back(id_storage.size());
+	key_bits = -1;
+	point_to_storage();
+}
+
+//counts the ids of every key, then the offsets are the prefix sums of the counts
+void Bucket_Array::build_dense(vector<pair<unsigned, uint32_t>>& entries, int key_bits) {
+	uint32_t num_of_keys = (uint32_t)1 << key_bits;
+	sort(entries.begin(), entries.end());
+
+	key_storage.clear();
+	offset_storage.assign(num_of_keys + 1, 0);
+	id_storage.clear();
+	id_storage.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); i++) {
+		offset_storage[entries[i].first + 1]++;
+		id_storage.push_back(entries[i].second);
+	}
+	for (uint32_t key = 0; key < num_of_keys; key++) {
+		offset_storage[key + 1] += offset_storage[key];
+	}
+	this->key_bits = key_bits;
+	point_to_storage();
+}
+
+bool Bucket_Array::get_bucket(unsigned key, const uint32_t **begin, const uint32_t **end) const {
+	if (key_bits >= 0) {
+		if (key >= num_of_buckets || offsets[key] == offsets[key + 1]) {
+			*begin = *end = NULL;
+			return false;
+		}
+		*begin = ids + offsets[key];
+		*end = ids + offsets[key + 1];
+		return true;
+	}
+
+	const unsigned *it = lower_bound(keys, keys + num_of_buckets, key);
+	if (it == keys + num_of_buckets || *it != key) {
+		*begin = *end = NULL;
+		return false;
+	}
+
+	size_t bucket = it - keys;
+	*begin = ids + offsets[bucket];
+	*end = ids + offsets[bucket + 1];
+	return true;
+}
+
+void Bucket_Array::save(Index_Writer& writer) const {
+	writer.write_value<int32_t>(key_bits);
+	writer.write_value<uint32_t>(num_of_buckets);
+	writer.write_value<uint32_t>(num_of_ids);
+	if (key_bits < 0) {
+		writer.write(keys, num_of_buckets*sizeof(unsigned));
+	}
+	writer.write(offsets, (num_of_buckets + 1)*sizeof(uint32_t));
+	writer.write(ids, num_of_ids*sizeof(uint32_t));
+}
+
+//points the buckets to the arrays of the mapped file, nothing is copied
+bool Bucket_Array::load(Index_Reader& reader, uint32_t num_of_items) {
+	int32_t key_bits;
+	uint32_t num_of_buckets, num_of_ids;
+	if (reader.read_value(key_bits) == false || reader.read_value(num_of_buckets) == false
+			|| reader.read_value(num_of_ids) == false || key_bits > BUCKET_ARRAY_MAX_KEY_BITS
+			|| (key_bits >= 0 && num_of_buckets != (uint32_t)1 << key_bits)) {
+		return false;
+	}
+
+	const unsigned *keys = key_bits < 0 ? reader.read_array<unsigned>(num_of_buckets) : NULL;
+	const uint32_t *offsets = reader.read_array<uint32_t>(num_of_buckets + 1);
+	const uint32_t *ids = reader.read_array<uint32_t>(num_of_ids);
+	if ((key_bits < 0 && keys == NULL) || offsets == NULL || ids == NULL
+			|| offsets[num_of_buckets] != num_of_ids) {
+		return false;
+	}
+	//get_bucket trusts the arrays, so a file that would send it out of them is rejected
+	for (uint32_t i = 0; i < num_of_buckets; i++) {
+		if (offsets[i] > offsets[i + 1] || (key_bits < 0 && i > 0 && keys[i - 1] >= keys[i])) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < num_of_ids; i++) {
+		if (ids[i] >= num_of_items) {
+			return false;
+		}
+	}
+
+	vector<unsigned>().swap(key_storage);
+	vector<uint32_t>().swap(offset_storage);
+	vector<uint32_t>().swap(id_storage);
+	this->keys = keys;
+	this->offsets = offsets;
+	this->ids = ids;
+	this->num_of_buckets = num_of_buckets;
+	this->num_of_ids = num_of_ids;
+	this->key_bits = key_bits < 0 ? -1 : key_bits;
+	return true;
+}
+
+void Bucket_Array::print() const {
+	for (uint32_t i = 0; i < num_of_buckets; i++) {
+		for (uint32_t j = offsets[i]; j < offsets[i + 1]; j++) {
+			cout <<"("<<(key_bits < 0 ? keys[i] : i)<<", "<<ids[j]<<") "<<endl;
+		}
+	}
+}
+
+void Bucket_Array::print_loads() const {
+	uint32_t non_empty = 0, max_load = 0;
+	double squares = 0;
+	for (uint32_t i = 0; i < num_of_buckets; i++) {
+		uint32_t load = offsets[i + 1] - offsets[i];
+		if (load != 0) {
+			non_empty++;
+			max_load = max(max_load, load);
+			squares += (double)load*load;
+		}
+	}
+	cout <<non_empty<<" non empty, mean load "<<(non_empty == 0 ? 0 : (double)num_of_ids/non_empty)
+		<<", max load "<<max_load<<", load of an item "<<(num_of_ids == 0 ? 0 : squares/num_of_ids)<<endl;
+}
@@ -0,0 +1,56 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+
+using namespace std;
+
+#include "../item/item.hpp"
+#include "../dataset/dataset.hpp"
+#include "../helping_functions/helping_functions.hpp"
+
+int main(int argc, char *argv[]) {
+	string input_file = "", output_file = "";
+	uint32_t element_type = DATASET_FILE_DOUBLE;
+	float radious = -1;
+
+	//READ COMMAND LINE ARGUMENTS
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			input_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-float") == 0) {
+			element_type = DATASET_FILE_FLOAT;
+		}
+		else if (strcmp(argv[i], "-type") == 0 && i + 1 < argc) {
+			element_type = get_element_type(argv[++i]);
+		}
+	}
+	if (input_file == "" || output_file == "" || element_type == 0) {
+		cout <<"usage: ./convert -i <text file> -o <dataset file> [-float] [-type <double|float|int16|uint8>]"<<endl;
+		return 1;
+	}
+
+	//READ THE VECTORS, A Radius LINE OF A QUERY FILE IS KEPT IN THE HEADER. INTEGER
+	//TYPES ROUND AND SATURATE THE COORDINATES WHEN THE FILE IS WRITTEN
+	Dataset<Type> items;
+	double time = get_wall_time();
+	read_vectors_from_file(input_file, items, radious);
+	if (items.get_size() == 0) {
+		cout <<"No vectors in the input file: "<<input_file<<endl;
+		return 1;
+	}
+	cout <<"Reading total time: "<<get_wall_time() - time<<endl;
+
+	//WRITE THE DATASET FILE
+	if (items.save(output_file, radious, element_type) == false) {
+		cout <<"Dataset file writing error: "<<output_file<<endl;
+		return 1;
+	}
+	cout <<"vectors: "<<items.get_size()<<endl;
+	cout <<"dimension: "<<items.get_dimension()<<endl;
+	cout <<"element type: "<<get_element_type_name(element_type)<<endl;
+	return 0;
+}
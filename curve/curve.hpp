@@ -1,29 +1,36 @@
 #ifndef CURVE_H
 #define CURVE_H
 
+#include <cstdint>
+
 #include "../point/point.hpp"
 
 class Curve {
 public:
-	Curve(string name, vector<Point*> *points);
-	Curve(vector<Point*> *points);
-	~Curve();
+	//length is the number of points reserved, insert_point() adds them
+	Curve(const string& name, int length);
+	Curve(int length);
 
 	string get_name(){return name;}
-	vector<Point*>& get_points() {return *points;}
-	void set_points(vector<Point*> *points) {this->points = points;}
+	uint32_t get_id() {return id;}
+	void set_id(uint32_t id) {this->id = id;}
+	//the points as x0 y0 x1 y1 ..., what the DTW reads
+	const Type* get_xy() const {return xy.data();}
+	Type get_x(int i) const {return xy[2*i];}
+	Type get_y(int i) const {return xy[2*i + 1];}
 	Curve* get_corresponding_curve() {return corresponding_curve;}
 	void set_corresponding_curve(Curve *corresponding_curve) {this->corresponding_curve = corresponding_curve;}
-	int get_length() {return points->size();}
+	int get_length() const {return xy.size()/2;}
 	void print();
 	void print_corresponding_curve();
 	void print_points();
-	void insert_point(Point *point);
+	void insert_point(Type x, Type y) {xy.push_back(x); xy.push_back(y);}
 	bool identical(Curve *curve);
 
 private:
 	string name;
-	vector<Point*> *points;
+	uint32_t id; //position in its file, the results of the searches refer to it
+	vector<Type> xy;
 	Curve *corresponding_curve;
 };
 
@@ -1,40 +1,30 @@
 #include <vector>
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
 #include "../point/point.hpp"
 #include "curve.hpp"
 
-Curve::Curve(string name, vector<Point*>* points) {
+Curve::Curve(const string& name, int length) {
 	this->name = name;
-	this->points = points;
+	this->id = 0;
 	this->corresponding_curve = NULL;
+	xy.reserve(2*length);
 }
 
-Curve::Curve(vector<Point*>* points) {
-	this->points = points;
+Curve::Curve(int length) {
+	this->id = 0;
 	this->corresponding_curve = NULL;
+	xy.reserve(2*length);
 }
 
-Curve::~Curve() {
-	for (size_t i = 0; i < points->size(); i++) {
-		delete (*points)[i];
-	}
-	delete points;
-}
-
-void Curve::insert_point(Point *point) {
-	points->push_back(point);
-}
-
+//the points the two curves have in common are equal
 bool Curve::identical(Curve *curve) {
-	typename vector<Point*>::iterator it1, it2;
-	it1 = this->get_points().begin();
-	it2 = curve->get_points().begin();
-
-	for (; it1 != this->get_points().end() && it2 != curve->get_points().end() ; it1++, it2++) {
-		if ((*it1)->equals(*it2) == false ) {
+	size_t size = min(xy.size(), curve->xy.size());
+	for (size_t i = 0; i < size; i++) {
+		if (xy[i] != curve->xy[i]) {
 			return false;
 		}
 	}
@@ -57,9 +47,7 @@ void Curve::print_corresponding_curve() {
 }
 
 void Curve::print_points() {
-	for (Point *point : *points) {
-		cout <<"(";
-		point->print_coordinates();
-		cout <<"), ";
+	for (int i = 0; i < get_length(); i++) {
+		cout <<"("<<get_x(i)<<", "<<get_y(i)<<", "<<"), ";
 	}
 }
\ No newline at end of file
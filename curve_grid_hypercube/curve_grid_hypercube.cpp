@@ -4,10 +4,6 @@ using namespace std;
 
 Curve_Grid_hypercube::Curve_Grid_hypercube(int L, int hash_table_dimension, int w, int k, double delta,
         int curve_dimension, unsigned m,unsigned M ,int table_size,int probes, double max_coord){
-    for (int i = 0; i < L; i++) {
-        Hash_Table_Hypercube *hash_table = new Hash_Table_Hypercube(table_size,hash_table_dimension ,w, k);
-        hash_tables.push_back(hash_table);
-    }
     vector<float> *random_vector;
     Point *grid;
     //create a uniformly random vector t in [0,d)^d for each hash table
@@ -35,16 +31,16 @@ Curve_Grid_hypercube::Curve_Grid_hypercube(int L, int hash_table_dimension, int
 	this->bits_of_each_hash = 32/k;
 	this->delta = delta;
 	if (k == 1) {
-		this->M = numeric_limits<unsigned>::max() ;
+		this->M = (unsigned long)numeric_limits<unsigned>::max() + 1;
 	}
 	else {
 		this->M = pow(2, bits_of_each_hash);
 	}
 	this->m = m;
-	for (size_t i = 0; i < table_size; i++) {
-		m_powers.push_back( pow_mod(m, i, M) );
-
-	}
+    for (int i = 0; i < L; i++) {
+        Hash_Table_Hypercube *hash_table = new Hash_Table_Hypercube(table_size,hash_table_dimension ,w, k, this->M, m);
+        hash_tables.push_back(hash_table);
+    }
 
 }
 
@@ -60,29 +56,38 @@ void Curve_Grid_hypercube::insert_curve(Curve *curve, list<Curve*> *grid_curves)
 	Item *item = NULL;
 	unsigned P_value;
 
+	if (curve->get_id() >= curves.size()) {
+		curves.resize(curve->get_id() + 1, NULL);
+	}
+	curves[curve->get_id()] = curve;
     for (size_t i = 0; i < L; i++) {
         convert_2d_curve_to_vector(curve, grids[i], delta, hash_table_dimension, curve_dimension,
 			&grid_curve, &item,max_coord);
 		grid_curves->push_back(grid_curve);
-		P_value = hash_tables[i]->p(*item->get_coordinates(), hash_table_dimension, table_size, w, k,bits_of_each_hash,  M, m_powers);
-		hash_tables[i]->insert(grid_curve, P_value);
+		P_value = hash_tables[i]->p(item->get_coordinates()->data());
+		hash_tables[i]->insert(curve->get_id(), P_value);
 		delete item;
 	}
 }
 
-void Curve_Grid_hypercube::ANN(Curve *query_curve, unsigned probes, Query_Result& query_result,bool check_for_identical_grid_flag) {
+//turns every cube into its read-only array form, called once after the bulk insert
+void Curve_Grid_hypercube::freeze() {
+	for (size_t i = 0; i < L; i++) {
+		hash_tables[i]->freeze();
+	}
+}
+
+//the capacity of neighbours nearest curves, their ids are the ones of the input curves
+void Curve_Grid_hypercube::kANN(Curve *query_curve, unsigned probes, KNN_Heap& neighbours,bool check_for_identical_grid_flag) {
     unsigned searched_items;
-    double best_distance = numeric_limits<double>::max();
     unsigned P_value;
     Curve *query_grid_curve;
     Item *query_item;
-    string best = "";
-    pair <unordered_multimap<unsigned, Curve*>::iterator, unordered_multimap<unsigned,Curve*>::iterator> ret;
-    unordered_multimap<unsigned, Curve*>::iterator it;
+    const uint32_t *begin, *end, *it;
     int flag =-1;
-    time_t time;
-    unsigned bucket_value;
-    time = clock();
+    unsigned vertex;
+    Visited_Set& visited_set = get_visited_set();
+    visited_set.start(curves.size());
     for (size_t i = 0; i < L; i++) {
         if(flag == 1){
             break;
@@ -90,12 +95,12 @@ void Curve_Grid_hypercube::ANN(Curve *query_curve, unsigned probes, Query_Result
         convert_2d_curve_to_vector(query_curve, grids[i], delta, hash_table_dimension,
 		curve_dimension, &query_grid_curve, &query_item,max_coord);
 
-        P_value = hash_tables[i]->p(*(query_item->get_coordinates()),hash_table_dimension, table_size, w, k, bits_of_each_hash, M,  m_powers);
+        P_value = hash_tables[i]->p(query_item->get_coordinates()->data());
         int bucketes_checked=0;
 
-        ret = hash_tables[i]->get_f_values_map()->equal_range(P_value);
+        hash_tables[i]->get_bucket(P_value, &begin, &end);
 		searched_items = 0;
-    	for (it = ret.first; it != ret.second; ++it) {
+    	for (it = begin; it != end; ++it) {
 			if (searched_items >= M_f) {
 				flag = 1;
 			}
@@ -103,69 +108,70 @@ void Curve_Grid_hypercube::ANN(Curve *query_curve, unsigned probes, Query_Result
         		break;
             }
 			if (check_for_identical_grid_flag == true) {
-				if (it->second->get_corresponding_curve()->identical(query_curve) == false) {
+				if (curves[*it]->identical(query_curve) == false) {
 					continue;
 				}
 			}
 
-			double cur_distance = Curve_Grid_distance(query_curve, it->second->get_corresponding_curve());
-			if (cur_distance < best_distance) {
-				best = it->second->get_name();
-				best_distance = cur_distance;
+			if (visited_set.visit(*it) == false) {
+				continue;
 			}
+			double cur_distance = Curve_Grid_distance(query_curve, curves[*it]);
+			neighbours.push(*it, cur_distance);
 			searched_items++;
 		}
-        unsigned nbuckets=hash_tables[i]->get_f_values_map()->bucket_count();
-        for (unsigned y=0; y<nbuckets; y++) {
-            if (searched_items >= M_f || bucketes_checked>=probes) {
-				break;
-			}
-            for (auto it = hash_tables[i]->get_f_values_map()->begin(y);it!= hash_tables[i]->get_f_values_map()->end(y);it++){
-				bucket_value=hash_tables[i]->get_f_values_map()->begin(y)->first;
-				break;
-	    	}
-            if (hammingDistance(P_value, bucket_value)==1){
-				bucketes_checked++;
-				ret = hash_tables[i]->get_f_values_map()->equal_range(bucket_value);
-				for (it = ret.first; it != ret.second; ++it) {
-					if (searched_items >= M_f) {
-						break;
-					}
-					double cur_distance = Curve_Grid_distance((query_curve), (it->second->get_corresponding_curve()));//apostasi querry apo ta alla pou iparxoun sto bucket
-					if (cur_distance < best_distance) {
-						best = it->second->get_name();
-						best_distance = cur_distance;
-					}
-					searched_items++;
+        //up to probes other vertices, in increasing hamming distance from the one of the query
+        Hamming_Ball hamming_ball(P_value, table_size);
+        while (searched_items < M_f && bucketes_checked < probes && hamming_ball.next(vertex)) {
+			bucketes_checked++;
+			hash_tables[i]->get_bucket(vertex, &begin, &end);
+			for (it = begin; it != end; ++it) {
+				if (searched_items >= M_f) {
+					break;
+				}
+				if (visited_set.visit(*it) == false) {
+					continue;
 				}
+				double cur_distance = Curve_Grid_distance((query_curve), (curves[*it]));//apostasi querry apo ta alla pou iparxoun sto bucket
+				neighbours.push(*it, cur_distance);
+				searched_items++;
 			}
         }
 		delete query_grid_curve;
 		delete query_item;
 
     }
-    time = clock() - time;
-	if (best != "") {
-		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+}
+
+void Curve_Grid_hypercube::ANN(Curve *query_curve, unsigned probes, Query_Result& query_result,bool check_for_identical_grid_flag) {
+	KNN_Heap neighbours(1);
+
+	double time;
+	time = get_wall_time();
+	kANN(query_curve, probes, neighbours, check_for_identical_grid_flag);
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
+
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(curves[neighbours.get_neighbour(0).id]->get_name());
 	}
 	else {
 		query_result.set_best_distance(-1);
 		query_result.set_time(-1);
 		query_result.set_best_item("NULL");
 	}
-
 }
 
 
-Hash_Table_Hypercube::Hash_Table_Hypercube(int table_size, int dimension, int w, int k){
+Hash_Table_Hypercube::Hash_Table_Hypercube(int table_size, int dimension, int w, int k, unsigned long M, unsigned m){
 	this->table_size=table_size;
     this->dimension = dimension;
+	this->frozen = false;
 
 	for (int i = 0; i < table_size; i++) {
-		unordered_map<unsigned,int> *it=new unordered_map<unsigned,int>;
-		g_value.push_back(it);
+		f_seeds.push_back(random_f_seed());
 	}
     for (size_t y = 0; y < table_size; y++) {
         vector < vector <float>* > *it1 =new vector < vector <float>* >;
@@ -176,36 +182,58 @@ Hash_Table_Hypercube::Hash_Table_Hypercube(int table_size, int dimension, int w,
         }
         s_array.push_back(it1);
     }
-}
 
-Hash_Table_Hypercube::~Hash_Table_Hypercube() {
+	hash_engine = new Hash_Engine(table_size, dimension, w, k, M, m);
 	for (int i = 0; i < table_size; i++) {
-		delete g_value[i];
+		hash_engine->set_s_array(i, *s_array[i]);
 	}
+}
 
+Hash_Table_Hypercube::~Hash_Table_Hypercube() {
 	for (vector < vector <float>* >* vv: s_array) {
 		for (vector <float>* v : *vv) {
 			delete v;
 		}
 		delete vv;
 	}
+	delete hash_engine;
 }
 
 
-void Hash_Table_Hypercube::insert(Curve *curve, unsigned g_value) {
-	f_value.insert(pair<unsigned, Curve*>(g_value,curve) );
+void Hash_Table_Hypercube::insert(uint32_t id, unsigned vertex) {
+	f_value.insert(pair<unsigned, uint32_t>(vertex,id) );
+}
+
+//moves the vertices out of the map into the arrays, with an offset for every vertex
+//when the cube is small enough, like the one of the vectors
+void Hash_Table_Hypercube::freeze() {
+	vector<pair<unsigned, uint32_t>> entries(f_value.begin(), f_value.end());
+	unordered_multimap<unsigned, uint32_t>().swap(f_value);
+	if (table_size <= BUCKET_ARRAY_MAX_KEY_BITS) {
+		buckets.build_dense(entries, table_size);
+	}
+	else {
+		buckets.build(entries);
+	}
+	frozen = true;
+}
+
+bool Hash_Table_Hypercube::get_bucket(unsigned vertex, const uint32_t **begin, const uint32_t **end) {
+	return buckets.get_bucket(vertex, begin, end);
 }
 
-unsigned Hash_Table_Hypercube::p(vector<Type> x , int dimension, int table_size, int w, int k,
-	int bits_of_each_hash, unsigned M, vector<unsigned>& m_powers) {
+//vertex of an input or a query curve, the f functions keep no state so many queries can hash at once
+unsigned Hash_Table_Hypercube::p(const Type *x) const {
+	unsigned g_values[table_size];
 	int result=0;
 	int p=0;
+	hash_engine->g_hash(x, g_values);
 	for (int i = 0; i < table_size; i++) {
-		p = f_hash_function(x,dimension,w,k,bits_of_each_hash,M,m_powers,*s_array[i],g_value,i);
+		p = f_hash_function(g_values[i],f_seeds[i]);
 		result |= p << (table_size -i -1);
 	}
 	return result;
 }
 double Curve_Grid_hypercube::Curve_Grid_distance(Curve *curve1, Curve *curve2) {
-	return DTW(curve1->get_points(), curve2->get_points());
+	return DTW(curve1, curve2);
 }
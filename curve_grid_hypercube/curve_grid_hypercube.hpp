@@ -13,6 +13,11 @@
 #include "../helping_functions/helping_functions.hpp"
 #include "../relevant_traversals/relevant_traversals.hpp"
 #include "../Tuple/tuple.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../visited_set/visited_set.hpp"
+#include "../hamming_ball/hamming_ball.hpp"
+#include "../bucket_array/bucket_array.hpp"
+#include "../hash_engine/hash_engine.hpp"
 
 
 typedef double Type;
@@ -20,22 +25,27 @@ typedef double Type;
 
 class Hash_Table_Hypercube {
 public:
-	Hash_Table_Hypercube(int table_size, int dimension, int w, int k);
+	Hash_Table_Hypercube(int table_size, int dimension, int w, int k, unsigned long M, unsigned m);
 	~Hash_Table_Hypercube();
-	void insert(Curve *curve, unsigned g_value);
+	void insert(uint32_t id, unsigned vertex);
+	void freeze();
+	bool get_bucket(unsigned vertex, const uint32_t **begin, const uint32_t **end);
 	Curve* find(Curve *item, int dimension, int w, int k, int bits_of_each_has, unsigned M);
-	unsigned p(vector<Type> x , int dimension, int table_size, int w, int k,
-		int bits_of_each_hash, unsigned M, vector<unsigned>& m_powers);
+	unsigned p(const Type *x) const;
 	void print();
 	int get_table_size() {return table_size;}
 	int get_dimension(){return dimension;}
+	bool is_frozen() {return frozen;}
 	//vector<vector<float>*>& get_s_array(){return s_array;};
-	unordered_multimap<unsigned, Curve*>* get_f_values_map(){return &f_value;};
+	unordered_multimap<unsigned, uint32_t>* get_f_values_map(){return &f_value;};
 
 private:
-	unordered_multimap <unsigned,Curve*> f_value;
-	vector< unordered_map<unsigned,int> *> g_value;
+	unordered_multimap <unsigned,uint32_t> f_value; //vertex -> curve id, until frozen
+	Bucket_Array buckets; //frozen form of f_value
+	bool frozen;
+	vector<uint64_t> f_seeds; //key of the f function of every cube dimension
 	vector<vector < vector <float>* >* > s_array;
+	Hash_Engine *hash_engine;//all the g of the f bits in one pass
 	int table_size;//k comnd line
 	int dimension;
 };
@@ -47,15 +57,20 @@ class Curve_Grid_hypercube {
 			int curve_dimension, unsigned m,unsigned M ,int table_size,int probes, double max_coord);
     ~Curve_Grid_hypercube();
     void insert_curve(Curve *curve,list<Curve*> *grid_curves);
+	void freeze();
 	int get_w() {return w;}
 	int get_k() {return k;}
 	int get_dimension() {return curve_dimension;}
 	void print_hash_tables();
+	void kANN(Curve *query_curve, unsigned probes, KNN_Heap& neighbours,
+			bool check_for_identical_grid_flag);
 	void ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result,
 			bool check_for_identical_grid_flag);
+	Curve* get_curve(uint32_t id) {return curves[id];}
 	double Curve_Grid_distance(Curve *curve1, Curve *curve2);
 private:
   vector<Hash_Table_Hypercube*>  hash_tables;
+	vector<Curve*> curves; //input curves by id
   vector<Point*> grids; //Each grid is identified from the random Point t
 	int table_size;//k comand line
   int L;
@@ -66,7 +81,6 @@ private:
   unsigned long M;// for g,h
 	unsigned m;
   unsigned bits_of_each_hash;
-	vector<unsigned> m_powers;
   double delta;
 	double max_coord;
 	int curve_dimension; //2D in our case
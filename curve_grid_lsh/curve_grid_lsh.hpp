@@ -3,6 +3,9 @@
 
 #include "../query_result/query_result.hpp"
 #include "../hash_table/hash_table.hpp"
+#include "../hash_engine/hash_engine.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../visited_set/visited_set.hpp"
 #include <list>
 
 class Curve_Grid_LSH {
@@ -12,8 +15,12 @@ public:
 	~Curve_Grid_LSH();
 
 	void insert_curve(Curve *curve, list<Curve*> *grid_curves);
+	void freeze();
+	void kANN(Curve *query_curve, unsigned threshhold, KNN_Heap& neighbours,
+		bool check_for_identical_grid_flag);
 	void ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result,
 		bool check_for_identical_grid_flag);
+	Curve* get_curve(uint32_t id) {return curves[id];}
 	void print_hash_tables();
 	void print_hash_tables_names();
 	int get_w() {return w;}
@@ -24,6 +31,8 @@ private:
 	double Curve_Grid_LSH_distance(Curve *curve1, Curve *curve2);
 
 	vector<Hash_Table*> hash_tables;
+	Hash_Engine *hash_engine; //g number i is the one of table i
+	vector<Curve*> curves; //input curves by id
 	vector<Point*> grids; //Each grid is identified from the random Point t
 	int w;
 	int k;
@@ -35,7 +44,6 @@ private:
 	int curve_dimension; //2D in our case
 	unsigned m;
 	double max_coord;
-	vector<unsigned> m_powers;
 };
 
 #endif
@@ -11,6 +11,7 @@ using namespace std;
 #include "../query_result/query_result.hpp"
 #include "../point/point.hpp"
 #include "../hash_table/hash_table.hpp"
+#include "../hash_engine/hash_engine.hpp"
 #include "../helping_functions/helping_functions.hpp"
 #include "curve_grid_lsh.hpp"
 
@@ -48,14 +49,15 @@ Curve_Grid_LSH::Curve_Grid_LSH(int L, int hash_table_dimension, int w, int k, fl
 	this->bits_of_each_hash = 32/k;
 	this->delta = delta;
 	if (k == 1) {
-		this->M = numeric_limits<unsigned>::max() + 1;
+		this->M = (unsigned long)numeric_limits<unsigned>::max() + 1;
 	}
 	else {
 		this->M = pow(2, bits_of_each_hash);
 	}
 	this->m = m;
-	for (size_t i = 0; i < hash_table_dimension; i++) {
-		m_powers.push_back( pow_mod(m, i, M) );
+	this->hash_engine = new Hash_Engine(L, hash_table_dimension, w, k, M, m);
+	for (size_t i = 0; i < L; i++) {
+		hash_engine->set_s_array(i, hash_tables[i]->get_s_array());
 	}
 }
 
@@ -64,6 +66,7 @@ Curve_Grid_LSH::~Curve_Grid_LSH() {
 		delete hash_tables[i];
 		delete grids[i];
 	}
+	delete hash_engine;
 }
 
 void Curve_Grid_LSH::insert_curve(Curve *curve, list<Curve*> *grid_curves) {
@@ -71,68 +74,84 @@ void Curve_Grid_LSH::insert_curve(Curve *curve, list<Curve*> *grid_curves) {
 	Item *item = NULL;
 	unsigned g_value;
 
+	if (curve->get_id() >= curves.size()) {
+		curves.resize(curve->get_id() + 1, NULL);
+	}
+	curves[curve->get_id()] = curve;
 	for (size_t i = 0; i < L; i++) {
 		convert_2d_curve_to_vector(curve, grids[i], delta, hash_table_dimension, curve_dimension,
 			&grid_curve, &item, max_coord);
 		grid_curves->push_back(grid_curve);
-		g_value = g_hash_function(*(item->get_coordinates()), hash_table_dimension,
-			w, k, bits_of_each_hash, M, hash_tables[i]->get_s_array(), m_powers);
+		g_value = hash_engine->g_hash(item->get_coordinates()->data(), (int)i);
 		hash_tables[i]->insert(grid_curve, g_value);
 		delete item;
 	}
 }
 
-void Curve_Grid_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result,
+//turns every table into its read-only sorted form, called once after the bulk insert
+void Curve_Grid_LSH::freeze() {
+	for (size_t i = 0; i < L; i++) {
+		hash_tables[i]->freeze();
+	}
+}
+
+//the capacity of neighbours nearest curves, their ids are the ones of the input curves
+void Curve_Grid_LSH::kANN(Curve *query_curve, unsigned threshhold, KNN_Heap& neighbours,
 		bool check_for_identical_grid_flag) {
 	unsigned searched_items;
-	double best_distance = numeric_limits<double>::max();
 	unsigned position, g_value;
 	Curve *query_grid_curve;
 	Item *query_item;
-	string best = "";
-	pair <unordered_multimap<unsigned, Curve*>::iterator, unordered_multimap<unsigned,Curve*>::iterator> ret;
-	unordered_multimap<unsigned, Curve*>::iterator it;
+	Curve* const *begin, * const *end, * const *it;
 
-	time_t time;
-	time = clock();
+	Visited_Set& visited_set = get_visited_set();
+	visited_set.start(curves.size());
 	for (size_t i = 0; i < L; i++) {
 		convert_2d_curve_to_vector(query_curve, grids[i], delta, hash_table_dimension,
 			curve_dimension, &query_grid_curve, &query_item, max_coord);
 
-		g_value = g_hash_function(*(query_item->get_coordinates()),
-				hash_table_dimension, w, k, bits_of_each_hash, M, hash_tables[i]->get_s_array(), m_powers);
+		g_value = hash_engine->g_hash(query_item->get_coordinates()->data(), (int)i);
 
-		ret = hash_tables[i]->get_map()->equal_range(g_value);
+		hash_tables[i]->get_bucket(g_value, &begin, &end);
 		searched_items = 0;
-		for (it = ret.first; it != ret.second; ++it) {
+		for (it = begin; it != end; ++it) {
 			if (searched_items >= threshhold) {
 				delete query_grid_curve;
 				delete query_item;
-				goto exit;
+				return;
 			}
 			if (check_for_identical_grid_flag == true) {
-				if (it->second->get_corresponding_curve()->identical(query_curve) == false) {
+				if ((*it)->get_corresponding_curve()->identical(query_curve) == false) {
 					continue;
 				}
 			}
 
-			double cur_distance = Curve_Grid_LSH_distance(query_curve, it->second->get_corresponding_curve());
-			if (cur_distance < best_distance) {
-				best = it->second->get_name();
-				best_distance = cur_distance;
+			if (visited_set.visit((*it)->get_corresponding_curve()->get_id()) == false) {
+				continue;
 			}
+			double cur_distance = Curve_Grid_LSH_distance(query_curve, (*it)->get_corresponding_curve());
+			neighbours.push((*it)->get_corresponding_curve()->get_id(), cur_distance);
 			searched_items++;
 		}
 		delete query_grid_curve;
 		delete query_item;
 	}
-	exit:
-	time = clock() - time;
+}
 
-	if (best != "") {
-		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+void Curve_Grid_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result,
+		bool check_for_identical_grid_flag) {
+	KNN_Heap neighbours(1);
+
+	double time;
+	time = get_wall_time();
+	kANN(query_curve, threshhold, neighbours, check_for_identical_grid_flag);
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
+
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(curves[neighbours.get_neighbour(0).id]->get_name());
 	}
 	else {
 		query_result.set_best_distance(-1);
@@ -142,7 +161,7 @@ void Curve_Grid_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Result&
 }
 
 double Curve_Grid_LSH::Curve_Grid_LSH_distance(Curve *curve1, Curve *curve2) {
-	return DTW(curve1->get_points(), curve2->get_points());
+	return DTW(curve1, curve2);
 }
 
 void Curve_Grid_LSH::print_hash_tables() {
@@ -13,7 +13,7 @@ Curve_Projection_hypercube::Curve_Projection_hypercube(int w, int k,
     this->table_size= M_Table;
 	this->M_f = M_f;
     if (k == 1) {
-        this->M = numeric_limits<unsigned>::max() + 1;
+        this->M = (unsigned long)numeric_limits<unsigned>::max() + 1;
     }
     else {
         this->M = pow(2, bits_of_each_hash);
@@ -60,63 +60,69 @@ void Curve_Projection_hypercube::insert_curve(Curve *curve) {
 	Item *item = NULL;
 	unsigned g_value;
 
+	if (curve->get_id() >= curves.size()) {
+		curves.resize(curve->get_id() + 1, NULL);
+	}
+	curves[curve->get_id()] = curve;
 	int table_row = curve->get_length() - 1;
 	for (size_t j = 0; j < table_size; j++) {
 		if (table[table_row][j] == NULL) {
             table[table_row][j] = new Relevant_Traversals_hypercube(table_row, j, table_size_hypercube, K_matrix, w, k, m, M);			
 		}
 
-		table[table_row][j]->insert(curve, w, k,
-		bits_of_each_hash, M, G_matrix, K_matrix, curve_dimension);
+		table[table_row][j]->insert(curve, G_matrix, K_matrix, curve_dimension);
 	}
 }
 
-void Curve_Projection_hypercube::ANN(Curve *query_curve, unsigned probes, Query_Result& query_result) {
+//turns every cube into its read-only array form, called once after the bulk insert
+void Curve_Projection_hypercube::freeze() {
+	for (size_t i = 0; i < table_size; i++) {
+		for (size_t j = 0; j < table_size; j++) {
+			if (table[i][j] != NULL) {
+				table[i][j]->freeze();
+			}
+		}
+	}
+}
+
+//the capacity of neighbours nearest curves, their ids are the ones of the input curves
+void Curve_Projection_hypercube::kANN(Curve *query_curve, unsigned probes, KNN_Heap& neighbours) {
         unsigned searched_items;
-    	double best_distance = numeric_limits<double>::max();
     	unsigned P_value;
     	Item *query_item;
-    	string best = "";
-    	unordered_multimap<unsigned, Curve*>::iterator it;
-    	pair <unordered_multimap<unsigned, Curve*>::iterator,
-    		unordered_multimap<unsigned,Curve*>::iterator> ret;
+    	const uint32_t *begin, *end, *it;
 
     	int table_column = query_curve->get_length() - 1;
     	int start_row = max(0, table_column - 2);
     	int end_row = min(table_size - 1, table_column + 2);
         int flag =-1;
-    	time_t time;
-    	time = clock();
-        int bucket_value=0;
+        unsigned vertex;
+        Visited_Set& visited_set = get_visited_set();
+        visited_set.start(curves.size());
         for (size_t row = start_row; row < end_row; row++) {
 			if (table[row][table_column] == NULL) {
 				continue;
 			}
 		
-            list<vector<Tuple*>*> relevant_traversals =
+            list<vector<Tuple*>*>& relevant_traversals =
     			table[row][table_column]->get_relevant_traversals();
 
 			Hash_Table_Hypercube** hash_tables =
 				table[row][table_column]->get_hash_tables();
 
-    		vector<vector<unsigned>*> m_powers_array =
-    			table[row][table_column]->get_m_powers_array();
-
             int h_i = 0;
             for (vector<Tuple*> *relevant_traversal : relevant_traversals) {
                 convert_2d_curve_to_vector_by_projection(*relevant_traversal, 1, G_matrix,
           				query_curve, K_matrix, curve_dimension, &query_item);
 
 
-                P_value = hash_tables[h_i]->p(*(query_item->get_coordinates()), 
-					hash_tables[h_i]->get_dimension(), table_size_hypercube, w, k,
-					bits_of_each_hash, M,  *(m_powers_array[h_i]));
+                P_value = hash_tables[h_i]->p(query_item->get_coordinates()->data());
 
                 int bucketes_checked=0;
-                ret = hash_tables[h_i]->get_f_values_map()->equal_range(P_value);
+                hash_tables[h_i]->get_bucket(P_value, &begin, &end);
 
         		searched_items = 0;
-             	for (it = ret.first; it != ret.second; ++it) {
+             	for (it = begin; it != end; ++it) {
         			if (searched_items >= M_f) {
         				flag =1;
         			}
@@ -124,37 +130,29 @@ void Curve_Projection_hypercube::ANN(Curve *query_curve, unsigned probes, Query_
                         break;
                     }
 
-        			double cur_distance = Curve_Grid_distance(query_curve, it->second);
-        			if (cur_distance < best_distance) {
-        				best = it->second->get_name();
-        				best_distance = cur_distance;
+        			if (visited_set.visit(*it) == false) {
+        				continue;
         			}
+        			double cur_distance = Curve_Grid_distance(query_curve, curves[*it]);
+        			neighbours.push(*it, cur_distance);
         			searched_items++;
         		}
 				
-                unsigned nbuckets=hash_tables[h_i]->get_f_values_map()->bucket_count();
-                for (unsigned y=0; y<nbuckets; y++) {
-                    if (searched_items >= M_f || bucketes_checked>=probes) {
-        				break;
-        			}
-                    for (auto it = hash_tables[h_i]->get_f_values_map()->begin(y);it!= hash_tables[h_i]->get_f_values_map()->end(y);it++){
-        				bucket_value=hash_tables[h_i]->get_f_values_map()->begin(y)->first;
-        				break;
-        	    	}
-                    if (hammingDistance(P_value, bucket_value)==1){
-        				bucketes_checked++;
-        				ret = hash_tables[h_i]->get_f_values_map()->equal_range(bucket_value);
-        				for (it = ret.first; it != ret.second; ++it) {
-        					if (searched_items >= M_f) {
-        						break;
-        					}
-        					double cur_distance = Curve_Grid_distance((query_curve), (it->second));//apostasi querry apo ta alla pou iparxoun sto bucket
-        					if (cur_distance < best_distance) {
-        						best = it->second->get_name();
-        						best_distance = cur_distance;
-        					}
-        					searched_items++;
+                //up to probes other vertices, in increasing hamming distance from the one of the query
+                Hamming_Ball hamming_ball(P_value, table_size_hypercube);
+                while (searched_items < M_f && bucketes_checked < probes && hamming_ball.next(vertex)) {
+        			bucketes_checked++;
+        			hash_tables[h_i]->get_bucket(vertex, &begin, &end);
+        			for (it = begin; it != end; ++it) {
+        				if (searched_items >= M_f) {
+        					break;
+        				}
+        				if (visited_set.visit(*it) == false) {
+        					continue;
         				}
+        				double cur_distance = Curve_Grid_distance((query_curve), (curves[*it]));//apostasi querry apo ta alla pou iparxoun sto bucket
+        				neighbours.push(*it, cur_distance);
+        				searched_items++;
         			}
                 }
 				
@@ -162,21 +160,31 @@ void Curve_Projection_hypercube::ANN(Curve *query_curve, unsigned probes, Query_
 				delete query_item;
             }
         }
-		time = clock() - time;
-		if (best != "") {
-			query_result.set_best_distance(best_distance);
-			query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-			query_result.set_best_item(best);
-		}
-		else {
-			query_result.set_best_distance(-1);
-			query_result.set_time(-1);
-			query_result.set_best_item("NULL");
-		}
+}
+
+void Curve_Projection_hypercube::ANN(Curve *query_curve, unsigned probes, Query_Result& query_result) {
+	KNN_Heap neighbours(1);
+
+	double time;
+	time = get_wall_time();
+	kANN(query_curve, probes, neighbours);
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
+
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(curves[neighbours.get_neighbour(0).id]->get_name());
+	}
+	else {
+		query_result.set_best_distance(-1);
+		query_result.set_time(-1);
+		query_result.set_best_item("NULL");
+	}
 }
 
 double Curve_Projection_hypercube::Curve_Grid_distance(Curve *curve1, Curve *curve2) {
-	return DTW(curve1->get_points(), curve2->get_points());
+	return DTW(curve1, curve2);
 }
 
 void Curve_Projection_hypercube::print_hash_tables() {
@@ -12,6 +12,9 @@
 #include "../helping_functions/helping_functions.hpp"
 #include "../relevant_traversals_hypercube/relevant_traversals_hypercube.hpp"
 #include "../Tuple/tuple.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../visited_set/visited_set.hpp"
+#include "../hamming_ball/hamming_ball.hpp"
 #include "../curve_projection_hypercube/curve_projection_hypercube.hpp"
 
 
@@ -21,11 +24,14 @@ class Curve_Projection_hypercube {
             int curve_dimension, unsigned m,unsigned M ,int K_matrix,int table_size_hypercube,int probes,int M_Table);
     ~Curve_Projection_hypercube();
     void insert_curve(Curve *curve);
+	void freeze();
     unsigned long long int Curve_Projection_LSH_distance(Curve *curve1, Curve *curve2);
     int get_w() {return w;}
 	int get_k() {return k;}
 	int get_dimension() {return curve_dimension;}
+	void kANN(Curve *query_curve, unsigned probes, KNN_Heap& neighbours);
 	void ANN(Curve *query_curve, unsigned probes, Query_Result& query_result);
+	Curve* get_curve(uint32_t id) {return curves[id];}
 	double Curve_Grid_distance(Curve *curve1, Curve *curve2);
 	void print_hash_tables();
 private:
@@ -39,9 +45,9 @@ private:
   	unsigned long M;// for g,h
 	unsigned m;
   	unsigned bits_of_each_hash;
-	vector<unsigned> m_powers;
 	int curve_dimension; //2D in our case
     Relevant_Traversals_hypercube ***table;
+	vector<Curve*> curves; //input curves by id
     double **G_matrix;
 	int K_matrix;
 };
@@ -4,6 +4,8 @@
 #include "../query_result/query_result.hpp"
 #include "../hash_table/hash_table.hpp"
 #include "../relevant_traversals/relevant_traversals.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../visited_set/visited_set.hpp"
 
 class Curve_Projection_LSH {
 public:
@@ -12,7 +14,10 @@ public:
 	~Curve_Projection_LSH();
 
 	void insert_curve(Curve *curve);
+	void freeze();
+	void kANN(Curve *query_curve, unsigned threshhold, KNN_Heap& neighbours);
 	void ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result);
+	Curve* get_curve(uint32_t id) {return curves[id];}
 	void print_hash_tables();
 	int get_w() {return w;}
 	int get_k() {return k;}
@@ -27,6 +32,7 @@ private:
 	unsigned m;
 	int table_size;
 	Relevant_Traversals ***table;
+	vector<Curve*> curves; //input curves by id
 	double **G_matrix;
 	int K_matrix;
 };
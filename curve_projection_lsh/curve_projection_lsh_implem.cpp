@@ -28,7 +28,7 @@ Curve_Projection_LSH::Curve_Projection_LSH(int L, int w, int k,
 	this->k = k;
 	this->bits_of_each_hash = 32/k;
 	if (k == 1) {
-		this->M = numeric_limits<unsigned>::max() + 1;
+		this->M = (unsigned long)numeric_limits<unsigned>::max() + 1;
 	}
 	else {
 		this->M = pow(2, bits_of_each_hash);
@@ -73,45 +73,56 @@ void Curve_Projection_LSH::insert_curve(Curve *curve) {
 	Item *item = NULL;
 	unsigned g_value;
 
+	if (curve->get_id() >= curves.size()) {
+		curves.resize(curve->get_id() + 1, NULL);
+	}
+	curves[curve->get_id()] = curve;
 	int table_row = curve->get_length() - 1;
 	for (size_t j = 0; j < table_size; j++) {
 		if (table[table_row][j] == NULL) {
 	        table[table_row][j] = new Relevant_Traversals(table_row, j, L, K_matrix, w, k, m, M);
 		}
-		table[table_row][j]->insert(curve, L, w, k,
-			bits_of_each_hash, M, G_matrix, K_matrix, curve_dimension);
+		table[table_row][j]->insert(curve, G_matrix, K_matrix, curve_dimension);
 	}
 }
 
-void Curve_Projection_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result) {
+//turns every table into its read-only sorted form, called once after the bulk insert
+void Curve_Projection_LSH::freeze() {
+	for (size_t i = 0; i < table_size; i++) {
+		for (size_t j = 0; j < table_size; j++) {
+			if (table[i][j] != NULL) {
+				table[i][j]->freeze();
+			}
+		}
+	}
+}
+
+//the capacity of neighbours nearest curves, their ids are the ones of the input curves
+void Curve_Projection_LSH::kANN(Curve *query_curve, unsigned threshhold, KNN_Heap& neighbours) {
 	unsigned searched_items;
-	double best_distance = numeric_limits<double>::max();
-	unsigned g_value;
+	unsigned g_values[L];
 	Item *query_item;
-	string best = "";
-	unordered_multimap<unsigned, Curve*>::iterator it;
-	pair <unordered_multimap<unsigned, Curve*>::iterator,
-		unordered_multimap<unsigned,Curve*>::iterator> ret;
+	Curve* const *begin, * const *end, * const *it;
 
 	int table_column = query_curve->get_length() - 1;
 	int start_row = max(0, table_column - 2);
 	int end_row = min(table_size - 1, table_column + 2);
 
-	time_t time;
-	time = clock();
+	Visited_Set& visited_set = get_visited_set();
+	visited_set.start(curves.size());
 	for (size_t row = start_row; row < end_row; row++) {
 		if (table[row][table_column] == NULL) {
 			continue;
 		}
 
-		list<vector<Tuple*>*> relevant_traversals = 
+		list<vector<Tuple*>*>& relevant_traversals = 
 			table[row][table_column]->get_relevant_traversals();
 
     	Hash_Table** hash_tables =
 			table[row][table_column]->get_hash_tables();
 
-		vector<vector<unsigned>*> m_powers_array = 
-			table[row][table_column]->get_m_powers_array();
+		vector<Hash_Engine*>& hash_engines =
+			table[row][table_column]->get_hash_engines();
 
 
 		int h_i = 0;
@@ -119,24 +130,21 @@ void Curve_Projection_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Re
 			convert_2d_curve_to_vector_by_projection(*relevant_traversal, 1, G_matrix,
 				query_curve, K_matrix, curve_dimension, &query_item);
 
+			hash_engines[h_i/L]->g_hash(query_item->get_coordinates()->data(), g_values);
 			for (size_t j = 0; j < L; j++) {
-				g_value = g_hash_function(*(query_item->get_coordinates()),
-					hash_tables[h_i]->get_dimension(), w, k, bits_of_each_hash, M,
-					hash_tables[h_i]->get_s_array(),(*m_powers_array[h_i/L]));
-
-				ret = hash_tables[h_i]->get_map()->equal_range(g_value);
+				hash_tables[h_i]->get_bucket(g_values[j], &begin, &end);
 				searched_items = 0;
-				for (it = ret.first; it != ret.second; ++it) {
+				for (it = begin; it != end; ++it) {
 					if (searched_items >= threshhold) {
 						delete query_item;
-						goto exit;
+						return;
 					}
 
-					double cur_distance = Curve_Projection_LSH_distance(query_curve, it->second);
-					if (cur_distance < best_distance) {
-						best = it->second->get_name();
-						best_distance = cur_distance;
+					if (visited_set.visit((*it)->get_id()) == false) {
+						continue;
 					}
+					double cur_distance = Curve_Projection_LSH_distance(query_curve, *it);
+					neighbours.push((*it)->get_id(), cur_distance);
 					searched_items++;
 				}
 				h_i++;
@@ -144,13 +152,21 @@ void Curve_Projection_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Re
 			delete query_item;
 		}
 	}
-	exit:
-	time = clock() - time;
+}
 
-	if (best != "") {
-		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+void Curve_Projection_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Result& query_result) {
+	KNN_Heap neighbours(1);
+
+	double time;
+	time = get_wall_time();
+	kANN(query_curve, threshhold, neighbours);
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
+
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(curves[neighbours.get_neighbour(0).id]->get_name());
 	}
 	else {
 		query_result.set_best_distance(-1);
@@ -160,7 +176,7 @@ void Curve_Projection_LSH::ANN(Curve *query_curve, unsigned threshhold, Query_Re
 }
 
 double Curve_Projection_LSH::Curve_Projection_LSH_distance(Curve *curve1, Curve *curve2) {
-	return DTW(curve1->get_points(), curve2->get_points());
+	return DTW(curve1, curve2);
 }
 
 void Curve_Projection_LSH::print_hash_tables() {
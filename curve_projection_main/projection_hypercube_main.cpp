@@ -12,6 +12,9 @@
 #include "../relevant_traversals_hypercube/relevant_traversals_hypercube.hpp"
 #include "../curve_projection_hypercube/curve_projection_hypercube.hpp"
 #include "../Tuple/tuple.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../ground_truth/ground_truth.hpp"
+#include "../latency_histogram/latency_histogram.hpp"
 
 #define M_DEFAULT 500
 #define K_DEFAULT 4
@@ -21,6 +24,7 @@
 #define CURVE_DIMENSION_DEFAULT 2
 #define EPS_DEFAULT 0.5
 #define M_TABLE_DEFAULT 6
+#define THREADS_DEFAULT 1
 
 int main(int argc, char *argv[]) {
     int k_s_g = K_DEFAULT;
@@ -28,6 +32,7 @@ int main(int argc, char *argv[]) {
 	int w = W_DEFAULT;
     int M = M_DEFAULT;
     int probes = PROBES_DEFAULT;
+    int threads = THREADS_DEFAULT;
     int curve_dimension = CURVE_DIMENSION_DEFAULT;
     double eps =EPS_DEFAULT;
     int M_table = M_TABLE_DEFAULT;
@@ -36,9 +41,10 @@ int main(int argc, char *argv[]) {
 
     //READ COMMAND LINE ARGUMENTS
     string input_file, query_file, output_file;
+    string ground_truth_file;
     int flag_defult=-1;
 
-    read_command_line_arguments_hypercube_projection(argv, argc, input_file, query_file,table_size_hypercube,M,probes,eps,output_file,flag_defult);
+    read_command_line_arguments_hypercube_projection(argv, argc, input_file, query_file,table_size_hypercube,M,probes,eps,output_file,flag_defult,threads,ground_truth_file);
     if(output_file==""){
         PRINT_ON_SCREAN=1;
     }
@@ -61,12 +67,13 @@ int main(int argc, char *argv[]) {
 
 
     //INSERT INPUT DATA
-    time_t time = clock();
+    double time = get_wall_time();
     for(Curve *curve : input_curves) {
         grid_projection.insert_curve(curve);
     }
-    time = clock() - time;
-    cout <<"Data insertion time: "<< ((double)time) / CLOCKS_PER_SEC <<endl<<endl;
+    grid_projection.freeze();
+    time = get_wall_time() - time;
+    cout <<"Data insertion time: "<< time <<endl<<endl;
 
 
     //READ QUERY CURVES FROM THE INPUT FILE
@@ -74,8 +81,42 @@ int main(int argc, char *argv[]) {
 	read_2d_curves_from_file(query_file, queries, max_curve_length, M_table);
 
     //HANDLE QUERIES
-    Query_Result ann_query_result, exhaustive_query_result;
-    time = clock();
+    //answer the queries in parallel, every query has its own results
+    vector<Curve*> query_curves(queries.begin(), queries.end());
+    uint32_t num_of_queries = query_curves.size();
+    vector<Query_Result> ann_query_results(num_of_queries);
+    vector<Query_Result> exhaustive_query_results(num_of_queries);
+    double wall_time = get_wall_time();
+    Latency_Histogram hit_latencies, empty_latencies;
+    Thread_Pool thread_pool(threads);
+
+    //Exact nearest neighbours, from the ground truth file when it has them
+    vector<Curve*> curves_by_id(input_curves.begin(), input_curves.end());
+    vector<KNN_Heap> exact_neighbours(num_of_queries, KNN_Heap(1));
+    vector<double> exact_times(num_of_queries);
+    get_ground_truth(ground_truth_file, input_file, query_file, M_table, input_curves.size(), exact_neighbours, exact_times, [&] {
+        thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+            double time = get_thread_time();
+            exhaustive_curve_search_k(&input_curves, query_curves[query_id], exact_neighbours[query_id]);
+            exact_neighbours[query_id].sort();
+            exact_times[query_id] = get_thread_time() - time;
+        });
+    });
+
+    thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+        Curve *query = query_curves[query_id];
+
+        //approximate nearest neighbor
+        grid_projection.ANN(query, probes, ann_query_results[query_id]);
+        record_latency(ann_query_results[query_id], hit_latencies, empty_latencies);
+
+        //Exact nearest neighbor
+        ground_truth_result(exact_neighbours[query_id], exact_times[query_id], curves_by_id,
+            exhaustive_query_results[query_id]);
+    });
+    wall_time = get_wall_time() - wall_time;
+
+    //print the results and the statistics in query order
     double sum_query_time = 0;
     double max_rate = -1;
     double sum_rate = 0;
@@ -83,12 +124,10 @@ int main(int argc, char *argv[]) {
     double total_distances = 0;
     int not_null = 0;
     FILE *out = fopen(output_file.c_str(), "w");
-    for(Curve *query: queries) {
-        //Approximate nearest neighbor
-        grid_projection.ANN(query, probes, ann_query_result);
-
-        //Exact nearest neighbor
-        exhaustive_curve_search(&input_curves, query, exhaustive_query_result);
+    for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+        Curve *query = query_curves[query_id];
+        Query_Result& ann_query_result = ann_query_results[query_id];
+        Query_Result& exhaustive_query_result = exhaustive_query_results[query_id];
 
         if(PRINT_ON_SCREAN==1)
             print_results(query->get_name(),ann_query_result,"Projection","Cube", exhaustive_query_result);
@@ -112,15 +151,16 @@ int main(int argc, char *argv[]) {
             not_null++;
         }
     }
-    time = clock() - time;
     cout <<endl;
-    cout <<"Handling of queries time: "<< ((double)time) / CLOCKS_PER_SEC<<endl;
+    cout <<"Handling of queries time: "<< wall_time
+        <<" ("<<thread_pool.get_num_of_threads()<<" threads)"<<endl;
     cout << "Average query time: "<<sum_query_time/not_null<<endl;
     cout << "Max rate: "<<max_rate<<endl;
     cout << "Average rate: "<<sum_rate/not_null<<endl;
     cout << "Found "<<not_null<<"/"<<queries.size()<<" approximate nearest neighbors"<<endl;
     cout << "Found "<<found_nearest<<"/"<<queries.size()<<" exact nearest neighbors"<<endl;
     cout << "Average distance: "<<total_distances/queries.size()<<endl;
+    print_latencies(hit_latencies, empty_latencies);
 
     delete_curves(input_curves);
     delete_curves(queries);
@@ -0,0 +1,110 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "../item/item.hpp"
+
+using namespace std;
+
+#define DATASET_ALIGNMENT 64
+
+//binary dataset files. A Dataset_File_Header, the coordinate block at offset
+//DATASET_ALIGNMENT (rows padded like the rows of a Dataset), then the names as
+//size + 1 offsets followed by the characters of all the names.
+#define DATASET_FILE_MAGIC 0x53434556 //"VECS"
+#define DATASET_FILE_VERSION 1
+
+#define DATASET_FILE_DOUBLE 1
+#define DATASET_FILE_FLOAT 2
+#define DATASET_FILE_INT16 3
+#define DATASET_FILE_UINT8 4
+
+struct Dataset_File_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t element_type;
+	uint32_t dimension;
+	uint32_t stride;
+	float radius; //-1 when the file had no Radius line
+	uint64_t size;
+	uint64_t coordinates_offset;
+	uint64_t names_offset;
+};
+
+//the DATASET_FILE_ code of the coordinates of a Dataset<T>
+template <typename T> struct Element_Type;
+template <> struct Element_Type<double> {static const uint32_t code = DATASET_FILE_DOUBLE;};
+template <> struct Element_Type<float> {static const uint32_t code = DATASET_FILE_FLOAT;};
+template <> struct Element_Type<int16_t> {static const uint32_t code = DATASET_FILE_INT16;};
+template <> struct Element_Type<uint8_t> {static const uint32_t code = DATASET_FILE_UINT8;};
+
+//bytes of one coordinate of an element type, 0 when it is not one
+size_t get_element_size(uint32_t element_type);
+//"double", "float", "int16" or "uint8", and back. 0 when the name is not one of them.
+const char* get_element_type_name(uint32_t element_type);
+uint32_t get_element_type(const string& name);
+
+//a coordinate read as a double in the element type, integers are rounded and saturated
+template <typename T> T to_element(double value) {
+	if (is_integral<T>::value) {
+		value = round(value);
+		value = fmin(fmax(value, (double)numeric_limits<T>::min()), (double)numeric_limits<T>::max());
+	}
+	return (T)value;
+}
+
+bool is_dataset_file(const string& file_name);
+//element type of a binary dataset file, 0 when the file is not one
+uint32_t get_dataset_file_element_type(const string& file_name);
+
+//all the vectors of a file in one aligned row-major block (size x stride) of T.
+//Every row starts at a DATASET_ALIGNMENT boundary and the padding is zero.
+template <typename T> class Dataset {
+public:
+	Dataset();
+	~Dataset();
+
+	uint32_t insert(const string& name, const T *coordinates, int dimension);
+	uint32_t grow(uint32_t count, uint64_t name_bytes);
+	void set_name(uint32_t id, uint64_t position, const char *name, size_t length);
+	void reserve(uint32_t capacity);
+	void print(uint32_t id);
+
+	bool save(const string& file_name, float radius, uint32_t element_type);
+	bool load(const string& file_name, float& radius);
+
+	const T* get_coordinates(uint32_t id) const {return coordinates + (size_t)id*stride;}
+	T* get_row(uint32_t id) {return storage + (size_t)id*stride;}
+	string get_name(uint32_t id) const {
+		return string(name_chars + name_offsets[id], name_offsets[id + 1] - name_offsets[id]);
+	}
+	uint64_t get_name_bytes() const {return name_offsets[size];}
+	uint32_t get_size() const {return size;}
+	int get_dimension() const {return dimension;}
+	int get_stride() const {return stride;}
+	void set_dimension(int dimension);
+private:
+	Dataset(const Dataset&);
+	Dataset& operator=(const Dataset&);
+
+	T *storage; //owned rows, NULL while the rows are those of a mapped file
+	const T *coordinates;
+	vector<char> name_storage;
+	vector<uint64_t> name_offset_storage;
+	const char *name_chars;
+	const uint64_t *name_offsets;
+	void *mapping;
+	size_t mapping_size;
+	uint32_t size;
+	uint32_t capacity;
+	int dimension;
+	int stride; //dimension rounded up to DATASET_ALIGNMENT
+};
+
+#endif
@@ -0,0 +1,315 @@
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "dataset.hpp"
+
+size_t get_element_size(uint32_t element_type) {
+	switch (element_type) {
+		case DATASET_FILE_DOUBLE: return sizeof(double);
+		case DATASET_FILE_FLOAT: return sizeof(float);
+		case DATASET_FILE_INT16: return sizeof(int16_t);
+		case DATASET_FILE_UINT8: return sizeof(uint8_t);
+	}
+	return 0;
+}
+
+const char* get_element_type_name(uint32_t element_type) {
+	switch (element_type) {
+		case DATASET_FILE_DOUBLE: return "double";
+		case DATASET_FILE_FLOAT: return "float";
+		case DATASET_FILE_INT16: return "int16";
+		case DATASET_FILE_UINT8: return "uint8";
+	}
+	return "unknown";
+}
+
+uint32_t get_element_type(const string& name) {
+	for (uint32_t element_type = DATASET_FILE_DOUBLE; element_type <= DATASET_FILE_UINT8; element_type++) {
+		if (name == get_element_type_name(element_type)) {
+			return element_type;
+		}
+	}
+	return 0;
+}
+
+//coordinate i of a row of a dataset file, as a double
+static double load_element(const char *row, int i, uint32_t element_type) {
+	switch (element_type) {
+		case DATASET_FILE_FLOAT: return ((const float*)row)[i];
+		case DATASET_FILE_INT16: return ((const int16_t*)row)[i];
+		case DATASET_FILE_UINT8: return ((const uint8_t*)row)[i];
+	}
+	return ((const double*)row)[i];
+}
+
+static void store_element(char *row, int i, uint32_t element_type, double value) {
+	switch (element_type) {
+		case DATASET_FILE_FLOAT: ((float*)row)[i] = to_element<float>(value); break;
+		case DATASET_FILE_INT16: ((int16_t*)row)[i] = to_element<int16_t>(value); break;
+		case DATASET_FILE_UINT8: ((uint8_t*)row)[i] = to_element<uint8_t>(value); break;
+		default: ((double*)row)[i] = value;
+	}
+}
+
+template <typename T> Dataset<T>::Dataset() {
+	this->storage = NULL;
+	this->coordinates = NULL;
+	this->name_offset_storage.push_back(0);
+	this->name_chars = NULL;
+	this->name_offsets = name_offset_storage.data();
+	this->mapping = NULL;
+	this->mapping_size = 0;
+	this->size = 0;
+	this->capacity = 0;
+	this->dimension = 0;
+	this->stride = 0;
+}
+
+template <typename T> Dataset<T>::~Dataset() {
+	free(storage);
+	if (mapping != NULL) {
+		munmap(mapping, mapping_size);
+	}
+}
+
+template <typename T> void Dataset<T>::set_dimension(int dimension) {
+	int per_line = DATASET_ALIGNMENT/sizeof(T);
+
+	this->dimension = dimension;
+	this->stride = (dimension + per_line - 1)/per_line*per_line;
+}
+
+template <typename T> void Dataset<T>::reserve(uint32_t capacity) {
+	if (capacity <= this->capacity || stride == 0) {
+		return;
+	}
+
+	size_t bytes = (size_t)capacity*stride*sizeof(T);
+	T *new_storage = (T*)aligned_alloc(DATASET_ALIGNMENT, bytes);
+	memset(new_storage, 0, bytes);
+	if (size != 0) {
+		memcpy(new_storage, coordinates, (size_t)size*stride*sizeof(T));
+	}
+	free(storage);
+	this->storage = new_storage;
+	this->coordinates = new_storage;
+	this->capacity = capacity;
+
+	//the names of a mapped file are copied out before the first insertion
+	if (name_offset_storage.size() != (size_t)size + 1) {
+		name_offset_storage.assign(name_offsets, name_offsets + size + 1);
+		name_storage.assign(name_chars, name_chars + name_offsets[size]);
+	}
+	name_offset_storage.reserve(capacity + 1);
+	name_chars = name_storage.data();
+	name_offsets = name_offset_storage.data();
+}
+
+template <typename T>
+uint32_t Dataset<T>::insert(const string& name, const T *coordinates, int dimension) {
+	if (this->dimension == 0) {
+		set_dimension(dimension);
+	}
+	if (size == capacity) {
+		reserve(capacity == 0 ? 1024 : 2*capacity);
+	}
+
+	//shorter rows are zero padded, longer ones are cut to the dataset dimension
+	T *row = storage + (size_t)size*stride;
+	memcpy(row, coordinates, min(dimension, this->dimension)*sizeof(T));
+	name_storage.insert(name_storage.end(), name.begin(), name.end());
+	name_offset_storage.push_back(name_storage.size());
+	name_chars = name_storage.data();
+	name_offsets = name_offset_storage.data();
+
+	return size++;
+}
+
+//appends count zero rows and name_bytes characters of names, for parsers that fill
+//them in place with get_row and set_name. Returns the id of the first new row.
+template <typename T> uint32_t Dataset<T>::grow(uint32_t count, uint64_t name_bytes) {
+	uint32_t first = size;
+
+	if (count == 0) {
+		return first;
+	}
+	if (size + count > capacity) {
+		reserve(max(size + count, 2*capacity));
+	}
+	name_storage.resize(name_storage.size() + name_bytes);
+	name_offset_storage.resize(size + count + 1, name_storage.size());
+	name_chars = name_storage.data();
+	name_offsets = name_offset_storage.data();
+	size += count;
+
+	return first;
+}
+
+//the name of a row added by grow, its characters start at position of the name blob
+template <typename T> void Dataset<T>::set_name(uint32_t id, uint64_t position, const char *name, size_t length) {
+	memcpy(name_storage.data() + position, name, length);
+	name_offset_storage[id + 1] = position + length;
+}
+
+template <typename T> void Dataset<T>::print(uint32_t id) {
+	const T *row = get_coordinates(id);
+
+	cout <<get_name(id)<<" ";
+	for (int i = 0; i < dimension; i++) {
+		cout <<(double)row[i]<<" ";
+	}
+	cout <<endl;
+}
+
+//writes the dataset as a binary dataset file, the coordinates converted to element_type
+template <typename T>
+bool Dataset<T>::save(const string& file_name, float radius, uint32_t element_type) {
+	static const char zeros[DATASET_ALIGNMENT] = {0};
+	Dataset_File_Header header;
+	if (get_element_size(element_type) == 0) {
+		element_type = DATASET_FILE_DOUBLE;
+	}
+	size_t element_size = get_element_size(element_type);
+	int per_line = DATASET_ALIGNMENT/element_size;
+	bool failed = false;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = DATASET_FILE_MAGIC;
+	header.version = DATASET_FILE_VERSION;
+	header.element_type = element_type;
+	header.dimension = dimension;
+	header.stride = (dimension + per_line - 1)/per_line*per_line;
+	header.radius = radius;
+	header.size = size;
+	header.coordinates_offset = DATASET_ALIGNMENT;
+	header.names_offset = DATASET_ALIGNMENT + header.size*header.stride*element_size;
+
+	FILE *file = fopen(file_name.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+	failed |= fwrite(zeros, DATASET_ALIGNMENT - sizeof(header), 1, file) != 1;
+	if (header.element_type == Element_Type<T>::code) {
+		failed |= size != 0 && fwrite(coordinates, (size_t)size*stride*sizeof(T), 1, file) != 1;
+	}
+	else {
+		vector<char> row(header.stride*element_size, 0);
+		for (uint32_t id = 0; id < size; id++) {
+			const T *x = get_coordinates(id);
+			for (int i = 0; i < dimension; i++) {
+				store_element(row.data(), i, element_type, x[i]);
+			}
+			failed |= fwrite(row.data(), row.size(), 1, file) != 1;
+		}
+	}
+	failed |= fwrite(name_offsets, (size_t)(size + 1)*sizeof(uint64_t), 1, file) != 1;
+	failed |= name_offsets[size] != 0 && fwrite(name_chars, name_offsets[size], 1, file) != 1;
+	failed |= fclose(file) != 0;
+	return failed == false;
+}
+
+//maps a binary dataset file into an empty dataset. Rows of T with the stride of this
+//build are used in place, the other element types are converted into owned rows.
+template <typename T> bool Dataset<T>::load(const string& file_name, float& radius) {
+	struct stat info;
+
+	if (size != 0 || dimension != 0) {
+		return false;
+	}
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(Dataset_File_Header)) {
+		close(fd);
+		return false;
+	}
+	void *file_mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (file_mapping == MAP_FAILED) {
+		return false;
+	}
+
+	const char *data = (const char*)file_mapping;
+	uint64_t file_size = info.st_size;
+	const Dataset_File_Header& header = *(const Dataset_File_Header*)data;
+	uint64_t element_size = get_element_size(header.element_type);
+	bool valid = header.magic == DATASET_FILE_MAGIC && header.version == DATASET_FILE_VERSION
+		&& element_size != 0 && header.dimension > 0 && header.stride >= header.dimension && header.size < UINT32_MAX
+		&& header.coordinates_offset%DATASET_ALIGNMENT == 0 && header.names_offset%sizeof(uint64_t) == 0
+		&& header.coordinates_offset <= file_size
+		&& header.size <= (file_size - header.coordinates_offset)/(header.stride*element_size)
+		&& header.names_offset <= file_size
+		&& (header.size + 1)*sizeof(uint64_t) <= file_size - header.names_offset;
+	const uint64_t *offsets = (const uint64_t*)(data + header.names_offset);
+	if (valid) {
+		uint64_t chars = file_size - header.names_offset - (header.size + 1)*sizeof(uint64_t);
+		valid = offsets[0] == 0;
+		for (uint64_t i = 0; valid && i < header.size; i++) {
+			valid = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= chars;
+		}
+	}
+	if (valid == false) {
+		munmap(file_mapping, info.st_size);
+		return false;
+	}
+
+	this->mapping = file_mapping;
+	this->mapping_size = info.st_size;
+	set_dimension(header.dimension);
+	if (header.element_type == Element_Type<T>::code && (int)header.stride == stride) {
+		this->coordinates = (const T*)(data + header.coordinates_offset);
+		this->capacity = header.size;
+	}
+	else {
+		const char *rows = data + header.coordinates_offset;
+		reserve(header.size);
+		for (uint64_t id = 0; id < header.size; id++) {
+			T *row = storage + id*stride;
+			const char *file_row = rows + id*header.stride*element_size;
+			for (int i = 0; i < dimension; i++) {
+				row[i] = to_element<T>(load_element(file_row, i, header.element_type));
+			}
+		}
+	}
+	this->name_offsets = offsets;
+	this->name_chars = (const char*)(offsets + header.size + 1);
+	this->size = header.size;
+	radius = header.radius;
+	return true;
+}
+
+bool is_dataset_file(const string& file_name) {
+	return get_dataset_file_element_type(file_name) != 0;
+}
+
+uint32_t get_dataset_file_element_type(const string& file_name) {
+	uint32_t magic_version_type[3] = {0, 0, 0};
+
+	FILE *file = fopen(file_name.c_str(), "rb");
+	if (file == NULL) {
+		return 0;
+	}
+	bool read = fread(magic_version_type, sizeof(magic_version_type), 1, file) == 1;
+	fclose(file);
+	if (read == false || magic_version_type[0] != DATASET_FILE_MAGIC) {
+		return 0;
+	}
+	return get_element_size(magic_version_type[2]) != 0 ? magic_version_type[2] : 0;
+}
+
+template class Dataset<double>;
+template class Dataset<float>;
+template class Dataset<int16_t>;
+template class Dataset<uint8_t>;
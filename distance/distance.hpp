@@ -0,0 +1,31 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <limits>
+#include <cstdint>
+
+#include "../item/item.hpp"
+
+using namespace std;
+
+//L1 distance of two rows. The inputs are borrowed, never copied.
+//With a threshold the sum stops as soon as it passes it, so a result
+//above the threshold is only a lower bound of the real distance.
+double manhattan_distance(const Type *x1, const Type *x2, int dimension);
+double manhattan_distance(const Type *x1, const Type *x2, int dimension, double threshold);
+//float rows are summed in double, int16 and uint8 rows in 64 bit integers
+double manhattan_distance(const float *x1, const float *x2, int dimension, double threshold);
+double manhattan_distance(const int16_t *x1, const int16_t *x2, int dimension, double threshold);
+double manhattan_distance(const uint8_t *x1, const uint8_t *x2, int dimension, double threshold);
+
+//name of the kernel picked for this cpu at startup for rows of T (avx512, avx2, sse2, scalar)
+template <typename T> const char* get_distance_kernel_name();
+
+//DTW with euclidean point distances of two curves of m1 and m2 points, given as flat
+//x0 y0 x1 y1 ... arrays. Only two rows of the table are kept, m1 or m2 long whichever is
+//shorter, in a buffer of the calling thread, so after its first calls it allocates nothing.
+double dtw_distance(const Type *xy1, int m1, const Type *xy2, int m2);
+//name of the kernel of the point distances of a dtw row
+const char* get_dtw_kernel_name();
+
+#endif
@@ -0,0 +1,645 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DISTANCE_X86
+#endif
+
+using namespace std;
+
+#include "distance.hpp"
+
+//the partial sum is compared to the threshold once per block of coordinates
+#define DISTANCE_BLOCK 64
+
+template <typename T> using Manhattan_Kernel = double (*)(const T*, const T*, int, double);
+//the euclidean distances of the point (x, y) to the m points of xy
+typedef void (*Point_Distances_Kernel)(Type x, Type y, const Type *xy, int m, double *distances);
+
+//|x1 - x2| in the type the sum of the row is kept in
+static inline double absolute_difference(double x1, double x2) {
+	return fabs(x1 - x2);
+}
+
+static inline double absolute_difference(float x1, float x2) {
+	return fabs((double)x1 - x2);
+}
+
+static inline int64_t absolute_difference(int16_t x1, int16_t x2) {
+	return abs((int)x1 - x2);
+}
+
+static inline int64_t absolute_difference(uint8_t x1, uint8_t x2) {
+	return abs((int)x1 - x2);
+}
+
+template <typename T, typename Sum>
+static double manhattan_distance_scalar(const T *x1, const T *x2, int dimension,
+		double threshold) {
+	Sum sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+static void point_distances_scalar(Type x, Type y, const Type *xy, int m, double *distances) {
+	for (int j = 0; j < m; j++) {
+		double dx = xy[2*j] - x;
+		double dy = xy[2*j + 1] - y;
+		distances[j] = sqrt(dx*dx + dy*dy);
+	}
+}
+
+#ifdef DISTANCE_X86
+
+static double manhattan_distance_sse2(const Type *x1, const Type *x2, int dimension,
+		double threshold) {
+	const __m128d sign = _mm_set1_pd(-0.0);
+	double sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m128d sum0 = _mm_setzero_pd();
+		__m128d sum1 = _mm_setzero_pd();
+		for (; i + 4 <= end; i += 4) {
+			__m128d d0 = _mm_sub_pd(_mm_loadu_pd(x1 + i), _mm_loadu_pd(x2 + i));
+			__m128d d1 = _mm_sub_pd(_mm_loadu_pd(x1 + i + 2), _mm_loadu_pd(x2 + i + 2));
+			sum0 = _mm_add_pd(sum0, _mm_andnot_pd(sign, d0));
+			sum1 = _mm_add_pd(sum1, _mm_andnot_pd(sign, d1));
+		}
+		sum0 = _mm_add_pd(sum0, sum1);
+		sum += _mm_cvtsd_f64(_mm_add_sd(sum0, _mm_unpackhi_pd(sum0, sum0)));
+		for (; i < end; i++) {
+			sum += fabs(x1[i] - x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx2")))
+static double manhattan_distance_avx2(const Type *x1, const Type *x2, int dimension,
+		double threshold) {
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	double sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m256d sum0 = _mm256_setzero_pd();
+		__m256d sum1 = _mm256_setzero_pd();
+		for (; i + 8 <= end; i += 8) {
+			__m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(x1 + i), _mm256_loadu_pd(x2 + i));
+			__m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(x1 + i + 4), _mm256_loadu_pd(x2 + i + 4));
+			sum0 = _mm256_add_pd(sum0, _mm256_andnot_pd(sign, d0));
+			sum1 = _mm256_add_pd(sum1, _mm256_andnot_pd(sign, d1));
+		}
+		sum0 = _mm256_add_pd(sum0, sum1);
+		__m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+		sum += _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+		for (; i < end; i++) {
+			sum += fabs(x1[i] - x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx512f")))
+static double manhattan_distance_avx512(const Type *x1, const Type *x2, int dimension,
+		double threshold) {
+	double sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m512d sum0 = _mm512_setzero_pd();
+		__m512d sum1 = _mm512_setzero_pd();
+		for (; i + 16 <= end; i += 16) {
+			__m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(x1 + i), _mm512_loadu_pd(x2 + i));
+			__m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(x1 + i + 8), _mm512_loadu_pd(x2 + i + 8));
+			sum0 = _mm512_add_pd(sum0, _mm512_abs_pd(d0));
+			sum1 = _mm512_add_pd(sum1, _mm512_abs_pd(d1));
+		}
+		if (i + 8 <= end) {
+			__m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(x1 + i), _mm512_loadu_pd(x2 + i));
+			sum0 = _mm512_add_pd(sum0, _mm512_abs_pd(d0));
+			i += 8;
+		}
+		//the last few coordinates of the row go through a masked load
+		if (i < end) {
+			__mmask8 mask = (__mmask8)((1u << (end - i)) - 1);
+			__m512d d1 = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, x1 + i),
+				_mm512_maskz_loadu_pd(mask, x2 + i));
+			sum1 = _mm512_add_pd(sum1, _mm512_abs_pd(d1));
+			i = end;
+		}
+		sum += _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+//float rows are widened to double before the subtraction
+static double manhattan_distance_float_sse2(const float *x1, const float *x2, int dimension,
+		double threshold) {
+	const __m128d sign = _mm_set1_pd(-0.0);
+	double sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m128d sum0 = _mm_setzero_pd();
+		__m128d sum1 = _mm_setzero_pd();
+		for (; i + 4 <= end; i += 4) {
+			__m128 a = _mm_loadu_ps(x1 + i);
+			__m128 b = _mm_loadu_ps(x2 + i);
+			__m128d d0 = _mm_sub_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b));
+			__m128d d1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+			sum0 = _mm_add_pd(sum0, _mm_andnot_pd(sign, d0));
+			sum1 = _mm_add_pd(sum1, _mm_andnot_pd(sign, d1));
+		}
+		sum0 = _mm_add_pd(sum0, sum1);
+		sum += _mm_cvtsd_f64(_mm_add_sd(sum0, _mm_unpackhi_pd(sum0, sum0)));
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx2")))
+static double manhattan_distance_float_avx2(const float *x1, const float *x2, int dimension,
+		double threshold) {
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	double sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m256d sum0 = _mm256_setzero_pd();
+		__m256d sum1 = _mm256_setzero_pd();
+		for (; i + 8 <= end; i += 8) {
+			__m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(x1 + i)),
+				_mm256_cvtps_pd(_mm_loadu_ps(x2 + i)));
+			__m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(x1 + i + 4)),
+				_mm256_cvtps_pd(_mm_loadu_ps(x2 + i + 4)));
+			sum0 = _mm256_add_pd(sum0, _mm256_andnot_pd(sign, d0));
+			sum1 = _mm256_add_pd(sum1, _mm256_andnot_pd(sign, d1));
+		}
+		sum0 = _mm256_add_pd(sum0, sum1);
+		__m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+		sum += _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx512f")))
+static double manhattan_distance_float_avx512(const float *x1, const float *x2, int dimension,
+		double threshold) {
+	double sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m512d sum0 = _mm512_setzero_pd();
+		__m512d sum1 = _mm512_setzero_pd();
+		for (; i + 16 <= end; i += 16) {
+			__m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x1 + i)),
+				_mm512_cvtps_pd(_mm256_loadu_ps(x2 + i)));
+			__m512d d1 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x1 + i + 8)),
+				_mm512_cvtps_pd(_mm256_loadu_ps(x2 + i + 8)));
+			sum0 = _mm512_add_pd(sum0, _mm512_abs_pd(d0));
+			sum1 = _mm512_add_pd(sum1, _mm512_abs_pd(d1));
+		}
+		//the last few coordinates of the row go through a masked load
+		if (i < end) {
+			__mmask16 mask = (__mmask16)((1u << (end - i)) - 1);
+			__m512 a = _mm512_maskz_loadu_ps(mask, x1 + i);
+			__m512 b = _mm512_maskz_loadu_ps(mask, x2 + i);
+			__m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(a)),
+				_mm512_cvtps_pd(_mm512_castps512_ps256(b)));
+			__m512d d1 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1))),
+				_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(b), 1))));
+			sum0 = _mm512_add_pd(sum0, _mm512_abs_pd(d0));
+			sum1 = _mm512_add_pd(sum1, _mm512_abs_pd(d1));
+			i = end;
+		}
+		sum += _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+//max - min of two int16 is their distance as an unsigned 16 bit value, it is
+//widened to 32 bit lanes for the block and the blocks are summed in 64 bits
+static double manhattan_distance_int16_sse2(const int16_t *x1, const int16_t *x2, int dimension,
+		double threshold) {
+	const __m128i zero = _mm_setzero_si128();
+	int64_t sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m128i sum0 = _mm_setzero_si128();
+		__m128i sum1 = _mm_setzero_si128();
+		for (; i + 8 <= end; i += 8) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(x1 + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(x2 + i));
+			__m128i d = _mm_sub_epi16(_mm_max_epi16(a, b), _mm_min_epi16(a, b));
+			sum0 = _mm_add_epi32(sum0, _mm_unpacklo_epi16(d, zero));
+			sum1 = _mm_add_epi32(sum1, _mm_unpackhi_epi16(d, zero));
+		}
+		sum0 = _mm_add_epi32(sum0, sum1);
+		sum0 = _mm_add_epi32(sum0, _mm_shuffle_epi32(sum0, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum0 = _mm_add_epi32(sum0, _mm_shuffle_epi32(sum0, _MM_SHUFFLE(2, 3, 0, 1)));
+		sum += (uint32_t)_mm_cvtsi128_si32(sum0);
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx2")))
+static double manhattan_distance_int16_avx2(const int16_t *x1, const int16_t *x2, int dimension,
+		double threshold) {
+	const __m256i zero = _mm256_setzero_si256();
+	int64_t sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m256i sum0 = _mm256_setzero_si256();
+		__m256i sum1 = _mm256_setzero_si256();
+		for (; i + 16 <= end; i += 16) {
+			__m256i a = _mm256_loadu_si256((const __m256i*)(x1 + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(x2 + i));
+			__m256i d = _mm256_sub_epi16(_mm256_max_epi16(a, b), _mm256_min_epi16(a, b));
+			sum0 = _mm256_add_epi32(sum0, _mm256_unpacklo_epi16(d, zero));
+			sum1 = _mm256_add_epi32(sum1, _mm256_unpackhi_epi16(d, zero));
+		}
+		sum0 = _mm256_add_epi32(sum0, sum1);
+		__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum0), _mm256_extracti128_si256(sum0, 1));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+		sum += (uint32_t)_mm_cvtsi128_si32(half);
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static double manhattan_distance_int16_avx512(const int16_t *x1, const int16_t *x2, int dimension,
+		double threshold) {
+	const __m512i zero = _mm512_setzero_si512();
+	int64_t sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m512i sum0 = _mm512_setzero_si512();
+		for (; i < end; i += 32) {
+			//the last few coordinates of the row go through a masked load
+			__mmask32 mask = end - i >= 32 ? (__mmask32)-1 : (__mmask32)((1u << (end - i)) - 1);
+			__m512i a = _mm512_maskz_loadu_epi16(mask, x1 + i);
+			__m512i b = _mm512_maskz_loadu_epi16(mask, x2 + i);
+			__m512i d = _mm512_sub_epi16(_mm512_max_epi16(a, b), _mm512_min_epi16(a, b));
+			sum0 = _mm512_add_epi32(sum0, _mm512_unpacklo_epi16(d, zero));
+			sum0 = _mm512_add_epi32(sum0, _mm512_unpackhi_epi16(d, zero));
+		}
+		i = end;
+		sum += (uint32_t)_mm512_reduce_add_epi32(sum0);
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+//psadbw sums the distances of 8 bytes into one 64 bit lane
+static double manhattan_distance_uint8_sse2(const uint8_t *x1, const uint8_t *x2, int dimension,
+		double threshold) {
+	int64_t sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m128i sum0 = _mm_setzero_si128();
+		for (; i + 16 <= end; i += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(x1 + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(x2 + i));
+			sum0 = _mm_add_epi64(sum0, _mm_sad_epu8(a, b));
+		}
+		sum += _mm_cvtsi128_si64(_mm_add_epi64(sum0, _mm_unpackhi_epi64(sum0, sum0)));
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx2")))
+static double manhattan_distance_uint8_avx2(const uint8_t *x1, const uint8_t *x2, int dimension,
+		double threshold) {
+	int64_t sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		__m256i sum0 = _mm256_setzero_si256();
+		for (; i + 32 <= end; i += 32) {
+			__m256i a = _mm256_loadu_si256((const __m256i*)(x1 + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(x2 + i));
+			sum0 = _mm256_add_epi64(sum0, _mm256_sad_epu8(a, b));
+		}
+		__m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum0), _mm256_extracti128_si256(sum0, 1));
+		sum += _mm_cvtsi128_si64(_mm_add_epi64(half, _mm_unpackhi_epi64(half, half)));
+		for (; i < end; i++) {
+			sum += absolute_difference(x1[i], x2[i]);
+		}
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static double manhattan_distance_uint8_avx512(const uint8_t *x1, const uint8_t *x2, int dimension,
+		double threshold) {
+	int64_t sum = 0;
+	int i = 0;
+	while (i < dimension) {
+		int end = min(dimension, i + DISTANCE_BLOCK);
+		//a block is one register, the end of the row goes through a masked load
+		__mmask64 mask = end - i >= 64 ? (__mmask64)-1 : (__mmask64)((1ull << (end - i)) - 1);
+		__m512i a = _mm512_maskz_loadu_epi8(mask, x1 + i);
+		__m512i b = _mm512_maskz_loadu_epi8(mask, x2 + i);
+		sum += _mm512_reduce_add_epi64(_mm512_sad_epu8(a, b));
+		i = end;
+		if (sum > threshold) {
+			return sum;
+		}
+	}
+	return sum;
+}
+
+//two points per step, the squares of their x and y are paired up by the unpacks
+static void point_distances_sse2(Type x, Type y, const Type *xy, int m, double *distances) {
+	const __m128d point = _mm_set_pd(y, x);
+	int j = 0;
+	for (; j + 2 <= m; j += 2) {
+		__m128d d0 = _mm_sub_pd(_mm_loadu_pd(xy + 2*j), point);
+		__m128d d1 = _mm_sub_pd(_mm_loadu_pd(xy + 2*j + 2), point);
+		d0 = _mm_mul_pd(d0, d0);
+		d1 = _mm_mul_pd(d1, d1);
+		__m128d sum = _mm_add_pd(_mm_unpacklo_pd(d0, d1), _mm_unpackhi_pd(d0, d1));
+		_mm_storeu_pd(distances + j, _mm_sqrt_pd(sum));
+	}
+	point_distances_scalar(x, y, xy + 2*j, m - j, distances + j);
+}
+
+//four points per step. hadd sums x^2 + y^2 inside the 128 bit lanes, which leaves the
+//points in the order 0 2 1 3, so the sums are permuted back before the store
+__attribute__((target("avx2")))
+static void point_distances_avx2(Type x, Type y, const Type *xy, int m, double *distances) {
+	const __m256d point = _mm256_set_pd(y, x, y, x);
+	int j = 0;
+	for (; j + 4 <= m; j += 4) {
+		__m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(xy + 2*j), point);
+		__m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(xy + 2*j + 4), point);
+		__m256d sum = _mm256_hadd_pd(_mm256_mul_pd(d0, d0), _mm256_mul_pd(d1, d1));
+		sum = _mm256_permute4x64_pd(sum, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_pd(distances + j, _mm256_sqrt_pd(sum));
+	}
+	point_distances_scalar(x, y, xy + 2*j, m - j, distances + j);
+}
+
+//eight points per step, the x and the y of the two registers are gathered apart
+__attribute__((target("avx512f")))
+static void point_distances_avx512(Type x, Type y, const Type *xy, int m, double *distances) {
+	const __m512d point = _mm512_set_pd(y, x, y, x, y, x, y, x);
+	const __m512i even = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+	const __m512i odd = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+	int j = 0;
+	for (; j + 8 <= m; j += 8) {
+		__m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(xy + 2*j), point);
+		__m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(xy + 2*j + 8), point);
+		d0 = _mm512_mul_pd(d0, d0);
+		d1 = _mm512_mul_pd(d1, d1);
+		__m512d sum = _mm512_add_pd(_mm512_permutex2var_pd(d0, even, d1),
+			_mm512_permutex2var_pd(d0, odd, d1));
+		_mm512_storeu_pd(distances + j, _mm512_sqrt_pd(sum));
+	}
+	point_distances_scalar(x, y, xy + 2*j, m - j, distances + j);
+}
+
+#endif
+
+static Point_Distances_Kernel select_point_distances_kernel(const char **name) {
+#ifdef DISTANCE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		*name = "avx512";
+		return point_distances_avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return point_distances_avx2;
+	}
+	*name = "sse2";
+	return point_distances_sse2;
+#else
+	*name = "scalar";
+	return point_distances_scalar;
+#endif
+}
+
+static Manhattan_Kernel<double> select_manhattan_kernel(const char **name, const double*) {
+#ifdef DISTANCE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		*name = "avx512";
+		return manhattan_distance_avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return manhattan_distance_avx2;
+	}
+	*name = "sse2";
+	return manhattan_distance_sse2;
+#else
+	*name = "scalar";
+	return manhattan_distance_scalar<double, double>;
+#endif
+}
+
+static Manhattan_Kernel<float> select_manhattan_kernel(const char **name, const float*) {
+#ifdef DISTANCE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		*name = "avx512";
+		return manhattan_distance_float_avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return manhattan_distance_float_avx2;
+	}
+	*name = "sse2";
+	return manhattan_distance_float_sse2;
+#else
+	*name = "scalar";
+	return manhattan_distance_scalar<float, double>;
+#endif
+}
+
+static Manhattan_Kernel<int16_t> select_manhattan_kernel(const char **name, const int16_t*) {
+#ifdef DISTANCE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) {
+		*name = "avx512";
+		return manhattan_distance_int16_avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return manhattan_distance_int16_avx2;
+	}
+	*name = "sse2";
+	return manhattan_distance_int16_sse2;
+#else
+	*name = "scalar";
+	return manhattan_distance_scalar<int16_t, int64_t>;
+#endif
+}
+
+static Manhattan_Kernel<uint8_t> select_manhattan_kernel(const char **name, const uint8_t*) {
+#ifdef DISTANCE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) {
+		*name = "avx512";
+		return manhattan_distance_uint8_avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return manhattan_distance_uint8_avx2;
+	}
+	*name = "sse2";
+	return manhattan_distance_uint8_sse2;
+#else
+	*name = "scalar";
+	return manhattan_distance_scalar<uint8_t, int64_t>;
+#endif
+}
+
+//the kernel of every element type, picked once at startup
+template <typename T> struct Manhattan_Kernels {
+	static const char *name;
+	static Manhattan_Kernel<T> kernel;
+};
+
+template <typename T> const char *Manhattan_Kernels<T>::name;
+template <typename T> Manhattan_Kernel<T> Manhattan_Kernels<T>::kernel
+	= select_manhattan_kernel(&Manhattan_Kernels<T>::name, (const T*)NULL);
+
+double manhattan_distance(const Type *x1, const Type *x2, int dimension) {
+	return Manhattan_Kernels<Type>::kernel(x1, x2, dimension, numeric_limits<double>::infinity());
+}
+
+double manhattan_distance(const Type *x1, const Type *x2, int dimension, double threshold) {
+	return Manhattan_Kernels<Type>::kernel(x1, x2, dimension, threshold);
+}
+
+double manhattan_distance(const float *x1, const float *x2, int dimension, double threshold) {
+	return Manhattan_Kernels<float>::kernel(x1, x2, dimension, threshold);
+}
+
+double manhattan_distance(const int16_t *x1, const int16_t *x2, int dimension, double threshold) {
+	return Manhattan_Kernels<int16_t>::kernel(x1, x2, dimension, threshold);
+}
+
+double manhattan_distance(const uint8_t *x1, const uint8_t *x2, int dimension, double threshold) {
+	return Manhattan_Kernels<uint8_t>::kernel(x1, x2, dimension, threshold);
+}
+
+template <typename T> const char* get_distance_kernel_name() {
+	return Manhattan_Kernels<T>::name;
+}
+
+template const char* get_distance_kernel_name<double>();
+template const char* get_distance_kernel_name<float>();
+template const char* get_distance_kernel_name<int16_t>();
+template const char* get_distance_kernel_name<uint8_t>();
+
+static const char *point_distances_kernel_name;
+static Point_Distances_Kernel point_distances_kernel = select_point_distances_kernel(&point_distances_kernel_name);
+
+//row i of the table is the distances of point i of the longer curve to the points of the
+//shorter one plus the min of the cells above, left and above left, so it needs row i - 1 only
+double dtw_distance(const Type *xy1, int m1, const Type *xy2, int m2) {
+	static thread_local vector<double> buffer;
+	if (m1 < m2) {
+		swap(xy1, xy2);
+		swap(m1, m2);
+	}
+	if (m2 == 0) {
+		return numeric_limits<double>::infinity();
+	}
+	if (buffer.size() < 3*(size_t)m2) {
+		buffer.resize(3*(size_t)m2);
+	}
+	double *previous = buffer.data();
+	double *current = previous + m2;
+	double *distances = current + m2;
+
+	point_distances_kernel(xy1[0], xy1[1], xy2, m2, previous);
+	for (int j = 1; j < m2; j++) {
+		previous[j] += previous[j - 1];
+	}
+	for (int i = 1; i < m1; i++) {
+		point_distances_kernel(xy1[2*i], xy1[2*i + 1], xy2, m2, distances);
+		//the cells above are known, so only the one on the left is left for the serial pass
+		for (int j = 1; j < m2; j++) {
+			current[j] = min(previous[j - 1], previous[j]);
+		}
+		current[0] = distances[0] + previous[0];
+		for (int j = 1; j < m2; j++) {
+			current[j] = distances[j] + min(current[j], current[j - 1]);
+		}
+		swap(previous, current);
+	}
+	return previous[m2 - 1];
+}
+
+const char* get_dtw_kernel_name() {
+	return point_distances_kernel_name;
+}
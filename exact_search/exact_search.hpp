@@ -0,0 +1,26 @@
+#ifndef EXACT_SEARCH_H
+#define EXACT_SEARCH_H
+
+#include <vector>
+
+#include "../dataset/dataset.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../thread_pool/thread_pool.hpp"
+
+using namespace std;
+
+//queries of one tile
+#define EXACT_SEARCH_QUERY_BLOCK 16
+//data rows of one tile, they stay in the cache while every query of the tile goes over them
+#define EXACT_SEARCH_DATA_BLOCK_BYTES (1 << 18)
+
+//exact k nearest neighbours of every query, k is the capacity of neighbours[i]. The
+//queries x data matrix is walked in tiles on the threads of the pool. With few queries
+//the data is cut into slabs too, and the heaps of the slabs are merged at the end.
+//neighbours[i] is sorted and times[i] is the cpu time spent on query i: its own passes
+//over the blocks of every slab plus the merge of its heaps.
+template <typename T>
+void exact_search(Dataset<T> *items, Dataset<T> *queries, vector<KNN_Heap>& neighbours,
+	vector<double>& times, Thread_Pool& thread_pool);
+
+#endif
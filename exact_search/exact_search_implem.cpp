@@ -0,0 +1,81 @@
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include "../helping_functions/helping_functions.hpp"
+#include "../distance/distance.hpp"
+#include "exact_search.hpp"
+
+template <typename T>
+void exact_search(Dataset<T> *items, Dataset<T> *queries, vector<KNN_Heap>& neighbours,
+		vector<double>& times, Thread_Pool& thread_pool) {
+	uint32_t num_of_queries = queries->get_size();
+	uint32_t size = items->get_size();
+	int dimension = items->get_dimension();
+	int capacity = num_of_queries == 0 ? 1 : neighbours[0].get_capacity();
+
+	uint32_t data_block = max((size_t)1, EXACT_SEARCH_DATA_BLOCK_BYTES/(max(items->get_stride(), 1)*sizeof(T)));
+	uint32_t query_blocks = (num_of_queries + EXACT_SEARCH_QUERY_BLOCK - 1)/EXACT_SEARCH_QUERY_BLOCK;
+	uint32_t data_blocks = max((size + data_block - 1)/data_block, 1u);
+
+	//about four tasks per thread, the extra ones cut the data into slabs
+	uint32_t wanted = 4*thread_pool.get_num_of_threads();
+	uint32_t slabs = min(data_blocks, max(1u, (wanted + query_blocks - 1)/max(query_blocks, 1u)));
+	uint32_t slab_blocks = (data_blocks + slabs - 1)/slabs;
+	slabs = (data_blocks + slab_blocks - 1)/slab_blocks;
+
+	vector<KNN_Heap> slab_neighbours((size_t)slabs*num_of_queries, KNN_Heap(capacity));
+	vector<double> slab_times((size_t)slabs*num_of_queries, 0);
+	thread_pool.run(query_blocks*slabs, [&](uint32_t task) {
+		uint32_t query_begin = task/slabs*EXACT_SEARCH_QUERY_BLOCK;
+		uint32_t query_end = min(num_of_queries, query_begin + EXACT_SEARCH_QUERY_BLOCK);
+		uint32_t slab = task%slabs;
+		uint32_t block_end = min(data_blocks, (slab + 1)*slab_blocks);
+		KNN_Heap *heaps = slab_neighbours.data() + (size_t)slab*num_of_queries;
+
+		//every query of the tile is charged the cpu time of its own pass over each block
+		double *query_times = slab_times.data() + (size_t)slab*num_of_queries;
+		double time = get_thread_time();
+		for (uint32_t block = slab*slab_blocks; block < block_end; block++) {
+			uint32_t begin = block*data_block;
+			uint32_t end = min(size, begin + data_block);
+			for (uint32_t query_id = query_begin; query_id < query_end; query_id++) {
+				const T *query = queries->get_coordinates(query_id);
+				KNN_Heap& heap = heaps[query_id];
+				for (uint32_t id = begin; id < end; id++) {
+					heap.push(id, manhattan_distance(query, items->get_coordinates(id), dimension,
+						heap.get_threshold()));
+				}
+				double now = get_thread_time();
+				query_times[query_id] += now - time;
+				time = now;
+			}
+		}
+	});
+
+	thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+		KNN_Heap& heap = neighbours[query_id];
+		double time = 0;
+		double merge_time = get_thread_time();
+
+		heap.clear();
+		for (uint32_t slab = 0; slab < slabs; slab++) {
+			KNN_Heap& slab_heap = slab_neighbours[(size_t)slab*num_of_queries + query_id];
+			for (int i = 0; i < slab_heap.get_size(); i++) {
+				heap.push(slab_heap.get_neighbour(i).id, slab_heap.get_neighbour(i).distance);
+			}
+			time += slab_times[(size_t)slab*num_of_queries + query_id];
+		}
+		heap.sort();
+		times[query_id] = time + get_thread_time() - merge_time;
+	});
+}
+
+#define INSTANTIATE_EXACT_SEARCH(T) \
+	template void exact_search(Dataset<T> *items, Dataset<T> *queries, vector<KNN_Heap>& neighbours, \
+		vector<double>& times, Thread_Pool& thread_pool);
+INSTANTIATE_EXACT_SEARCH(double)
+INSTANTIATE_EXACT_SEARCH(float)
+INSTANTIATE_EXACT_SEARCH(int16_t)
+INSTANTIATE_EXACT_SEARCH(uint8_t)
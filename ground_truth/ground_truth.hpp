@@ -0,0 +1,42 @@
+#ifndef GROUND_TRUTH_H
+#define GROUND_TRUTH_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+#include "../dataset/dataset.hpp"
+#include "../curve/curve.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../query_result/query_result.hpp"
+
+using namespace std;
+
+//hash of the bytes of a file, the key of a ground truth file. 0 when it cannot be read.
+uint64_t hash_file(const string& file_name);
+
+//ground truth files keep the exact top-k ids and distances and the search time of every
+//query, keyed by the hashes of the input and query files. variant is anything else that
+//changes the answers, like the M_table cut of the projection mains. Loading rejects a file
+//with ids outside the num_of_items input items.
+bool load_ground_truth(const string& file_name, uint64_t input_hash, uint64_t query_hash,
+	uint64_t variant, uint32_t num_of_items, vector<KNN_Heap>& neighbours, vector<double>& times);
+bool save_ground_truth(const string& file_name, uint64_t input_hash, uint64_t query_hash,
+	uint64_t variant, vector<KNN_Heap>& neighbours, vector<double>& times);
+
+//fills neighbours (sorted) and times from file_name when it holds the ground truth of these
+//files for at least as many neighbours. Otherwise runs search and saves its results there.
+//An empty file_name only runs search. Returns true when the ground truth was loaded.
+bool get_ground_truth(const string& file_name, const string& input_file, const string& query_file,
+	uint64_t variant, uint32_t num_of_items, vector<KNN_Heap>& neighbours, vector<double>& times,
+	const function<void()>& search);
+
+//the nearest neighbour of a ground truth as the result of an exhaustive search
+template <typename T>
+void ground_truth_result(const KNN_Heap& neighbours, double time, Dataset<T> *items,
+	Query_Result& query_result);
+void ground_truth_result(const KNN_Heap& neighbours, double time, vector<Curve*>& curves,
+	Query_Result& query_result);
+
+#endif
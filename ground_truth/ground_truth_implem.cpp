@@ -0,0 +1,179 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
+#include "../index_file/index_file.hpp"
+#include "../text_file/text_file.hpp"
+#include "ground_truth.hpp"
+
+uint64_t hash_file(const string& file_name) {
+	const uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+	Text_File file;
+
+	if (file.open(file_name) == false) {
+		return 0;
+	}
+	const char *p = file.get_begin();
+	size_t size = file.get_end() - p;
+	uint64_t hash = size*multiplier;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		memcpy(&word, p + i, 8);
+		hash = (hash ^ word)*multiplier;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; i++) {
+		hash = (hash ^ (uint8_t)p[i])*multiplier;
+	}
+	hash ^= hash >> 32;
+	return hash == 0 ? 1 : hash;
+}
+
+bool load_ground_truth(const string& file_name, uint64_t input_hash, uint64_t query_hash,
+		uint64_t variant, uint32_t num_of_items, vector<KNN_Heap>& neighbours, vector<double>& times) {
+	uint64_t file_input_hash, file_query_hash, file_variant;
+	uint32_t num_of_queries, k;
+	Index_Reader reader;
+
+	if (reader.open(file_name, INDEX_FILE_GROUND_TRUTH) == false
+			|| reader.read_value(file_input_hash) == false || reader.read_value(file_query_hash) == false
+			|| reader.read_value(file_variant) == false || reader.read_value(num_of_queries) == false
+			|| reader.read_value(k) == false) {
+		return false;
+	}
+	if (file_input_hash != input_hash || file_query_hash != query_hash || file_variant != variant
+			|| num_of_queries != neighbours.size()
+			|| (num_of_queries != 0 && (int)k < neighbours[0].get_capacity())) {
+		return false;
+	}
+	const uint32_t *counts = reader.read_array<uint32_t>(num_of_queries);
+	const uint32_t *ids = reader.read_array<uint32_t>((size_t)num_of_queries*k);
+	const double *distances = reader.read_array<double>((size_t)num_of_queries*k);
+	const double *file_times = reader.read_array<double>(num_of_queries);
+	if (counts == NULL || ids == NULL || distances == NULL || file_times == NULL) {
+		return false;
+	}
+	//a corrupt file must not send ids past the input items into the result printing
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		if (counts[query_id] > k) {
+			return false;
+		}
+		for (uint32_t i = 0; i < counts[query_id]; i++) {
+			if (ids[(size_t)query_id*k + i] >= num_of_items) {
+				return false;
+			}
+		}
+	}
+
+	//the neighbours of a query are stored nearest first, a smaller k keeps the first ones
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		KNN_Heap& heap = neighbours[query_id];
+		uint32_t count = min(counts[query_id], (uint32_t)heap.get_capacity());
+		heap.clear();
+		for (uint32_t i = 0; i < count; i++) {
+			heap.push(ids[(size_t)query_id*k + i], distances[(size_t)query_id*k + i]);
+		}
+		heap.sort();
+		times[query_id] = file_times[query_id];
+	}
+	return true;
+}
+
+//neighbours have to be sorted already
+bool save_ground_truth(const string& file_name, uint64_t input_hash, uint64_t query_hash,
+		uint64_t variant, vector<KNN_Heap>& neighbours, vector<double>& times) {
+	uint32_t num_of_queries = neighbours.size();
+	uint32_t k = num_of_queries == 0 ? 0 : neighbours[0].get_capacity();
+	vector<uint32_t> counts(num_of_queries);
+	vector<uint32_t> ids((size_t)num_of_queries*k, 0);
+	vector<double> distances((size_t)num_of_queries*k, 0);
+	Index_Writer writer;
+
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		KNN_Heap& heap = neighbours[query_id];
+		counts[query_id] = heap.get_size();
+		for (int i = 0; i < heap.get_size(); i++) {
+			ids[(size_t)query_id*k + i] = heap.get_neighbour(i).id;
+			distances[(size_t)query_id*k + i] = heap.get_neighbour(i).distance;
+		}
+	}
+
+	if (writer.open(file_name, INDEX_FILE_GROUND_TRUTH) == false) {
+		return false;
+	}
+	writer.write_value(input_hash);
+	writer.write_value(query_hash);
+	writer.write_value(variant);
+	writer.write_value(num_of_queries);
+	writer.write_value(k);
+	writer.write(counts.data(), counts.size()*sizeof(uint32_t));
+	writer.write(ids.data(), ids.size()*sizeof(uint32_t));
+	writer.write(distances.data(), distances.size()*sizeof(double));
+	writer.write(times.data(), (size_t)num_of_queries*sizeof(double));
+	return writer.close();
+}
+
+bool get_ground_truth(const string& file_name, const string& input_file, const string& query_file,
+		uint64_t variant, uint32_t num_of_items, vector<KNN_Heap>& neighbours, vector<double>& times,
+		const function<void()>& search) {
+	if (file_name == "") {
+		search();
+		return false;
+	}
+
+	uint64_t input_hash = hash_file(input_file);
+	uint64_t query_hash = hash_file(query_file);
+	if (load_ground_truth(file_name, input_hash, query_hash, variant, num_of_items, neighbours, times)) {
+		cout <<"Ground truth loaded from: "<<file_name<<endl;
+		return true;
+	}
+	search();
+	if (save_ground_truth(file_name, input_hash, query_hash, variant, neighbours, times)) {
+		cout <<"Ground truth saved to: "<<file_name<<endl;
+	}
+	else {
+		cout <<"Ground truth saving error: "<<file_name<<endl;
+	}
+	return false;
+}
+
+template <typename T>
+void ground_truth_result(const KNN_Heap& neighbours, double time, Dataset<T> *items,
+		Query_Result& query_result) {
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(items->get_name(neighbours.get_neighbour(0).id));
+	}
+	else {
+		query_result.set_best_distance(-1);
+		query_result.set_time(-1);
+		query_result.set_best_item("NULL");
+	}
+}
+
+#define INSTANTIATE_GROUND_TRUTH_RESULT(T) \
+	template void ground_truth_result(const KNN_Heap& neighbours, double time, Dataset<T> *items, \
+		Query_Result& query_result);
+INSTANTIATE_GROUND_TRUTH_RESULT(double)
+INSTANTIATE_GROUND_TRUTH_RESULT(float)
+INSTANTIATE_GROUND_TRUTH_RESULT(int16_t)
+INSTANTIATE_GROUND_TRUTH_RESULT(uint8_t)
+
+void ground_truth_result(const KNN_Heap& neighbours, double time, vector<Curve*>& curves,
+		Query_Result& query_result) {
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(curves[neighbours.get_neighbour(0).id]->get_name());
+	}
+	else {
+		query_result.set_best_distance(-1);
+		query_result.set_time(-1);
+		query_result.set_best_item("NULL");
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef HAMMING_BALL_H
+#define HAMMING_BALL_H
+
+#include <cstdint>
+
+using namespace std;
+
+//the vertices of a hypercube of bits dimensions around a center vertex, in increasing
+//hamming distance: every vertex at distance 1, then every vertex at distance 2 and so on.
+//The flipped bits of one distance are the combinations of that many bits in increasing
+//order, so a probe costs a few integer operations whatever the size of the table.
+class Hamming_Ball {
+public:
+	Hamming_Ball(unsigned center, int bits);
+
+	//the next vertex, false once all the 2^bits - 1 other vertices are out
+	bool next(unsigned& vertex);
+	int get_distance() const {return distance;}
+private:
+	uint64_t flips; //the bits the last vertex flips, 0 before the first one
+	unsigned center;
+	int bits;
+	int distance;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include <cstdint>
+
+using namespace std;
+
+#include "hamming_ball.hpp"
+
+Hamming_Ball::Hamming_Ball(unsigned center, int bits) {
+	this->flips = 0;
+	this->center = center;
+	this->bits = bits;
+	this->distance = 0;
+}
+
+bool Hamming_Ball::next(unsigned& vertex) {
+	if (flips != 0) {
+		//the next larger number with as many set bits (Gosper's hack)
+		uint64_t lowest = flips & -flips;
+		uint64_t ripple = flips + lowest;
+		flips = (((ripple ^ flips) >> 2)/lowest) | ripple;
+	}
+	if (flips == 0 || flips >> bits != 0) {
+		if (distance >= bits) {
+			return false;
+		}
+		distance++;
+		flips = ((uint64_t)1 << distance) - 1;
+	}
+	vertex = center ^ (unsigned)flips;
+	return true;
+}
@@ -0,0 +1,53 @@
+#ifndef HASH_ENGINE_H
+#define HASH_ENGINE_H
+
+#include <vector>
+#include <cstdint>
+
+#include "../item/item.hpp"
+
+using namespace std;
+
+//evaluates every g function of an index (L tables of lsh, the f bits of the cube)
+//in one pass over the input. The shifts of g number i are kept in rows i*k .. i*k+k-1
+//of one aligned matrix, already divided by w, and the powers of m are stored in
+//coordinate order, so a sub-hash is a single streaming loop with no allocation.
+class Hash_Engine {
+public:
+	Hash_Engine(int num_of_g, int dimension, int w, int k, unsigned long M, unsigned m);
+	~Hash_Engine();
+
+	void set_s_array(int g, vector<vector<float>*>& s_array);
+	//x is a row of double, float, int16_t or uint8_t
+	template <typename T> void g_hash(const T *x, unsigned *g_values) const;
+	template <typename T> unsigned g_hash(const T *x, int g) const;
+	template <typename T>
+	int g_probe(const T *x, int num_of_probes, unsigned *g_values, unsigned *probe_values) const;
+
+	//every a_j of every sub-hash moved up or down, the most probes one g has
+	int get_max_probes() const {return 2*k*dimension;}
+	int get_num_of_g() const {return num_of_g;}
+	int get_k() const {return k;}
+	unsigned long get_M() const {return M;}
+private:
+	Hash_Engine(const Hash_Engine&);
+	Hash_Engine& operator=(const Hash_Engine&);
+
+	template <typename T> void scale(const T *x, double *scaled) const;
+	unsigned sub_hash(const double *scaled, int row) const;
+	unsigned perturb(unsigned sub_hash_value, int coordinate, bool up) const;
+
+	double *shifts; //(num_of_g*k) x stride, s/w
+	uint32_t *powers; //m^(dimension-1-i) mod M, zero on the padding
+	int num_of_g;
+	int dimension;
+	int stride; //dimension rounded up to a whole vector register
+	int k;
+	int bits_of_each_hash;
+	double inverse_w;
+	unsigned long M;
+	uint32_t mask; //M - 1, used when M is a power of two
+	bool power_of_two;
+};
+
+#endif
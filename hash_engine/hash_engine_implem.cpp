@@ -0,0 +1,286 @@
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HASH_ENGINE_X86
+#endif
+
+using namespace std;
+
+#include "../helping_functions/helping_functions.hpp"
+#include "hash_engine.hpp"
+
+#define HASH_ENGINE_ALIGNMENT 64
+
+//sum of floor(scaled[i] - row[i])*powers[i] modulo 2^32. The padding of the
+//rows has zero powers, so the kernels run over whole registers without a tail.
+typedef uint32_t (*Sub_Hash_Kernel)(const double*, const double*, const uint32_t*, int);
+
+static uint32_t sub_hash_scalar(const double *scaled, const double *row,
+		const uint32_t *powers, int stride) {
+	uint32_t sum = 0;
+	for (int i = 0; i < stride; i++) {
+		double value = scaled[i] - row[i];
+		int32_t a = (int32_t)value;
+		a -= (value < a);
+		sum += (uint32_t)a*powers[i];
+	}
+	return sum;
+}
+
+#ifdef HASH_ENGINE_X86
+
+__attribute__((target("avx2")))
+static uint32_t sub_hash_avx2(const double *scaled, const double *row,
+		const uint32_t *powers, int stride) {
+	__m128i sum0 = _mm_setzero_si128();
+	__m128i sum1 = _mm_setzero_si128();
+	for (int i = 0; i < stride; i += 8) {
+		__m256d v0 = _mm256_floor_pd(_mm256_sub_pd(_mm256_loadu_pd(scaled + i), _mm256_load_pd(row + i)));
+		__m256d v1 = _mm256_floor_pd(_mm256_sub_pd(_mm256_loadu_pd(scaled + i + 4), _mm256_load_pd(row + i + 4)));
+		__m128i p0 = _mm_load_si128((const __m128i*)(powers + i));
+		__m128i p1 = _mm_load_si128((const __m128i*)(powers + i + 4));
+		sum0 = _mm_add_epi32(sum0, _mm_mullo_epi32(_mm256_cvttpd_epi32(v0), p0));
+		sum1 = _mm_add_epi32(sum1, _mm_mullo_epi32(_mm256_cvttpd_epi32(v1), p1));
+	}
+	sum0 = _mm_add_epi32(sum0, sum1);
+	sum0 = _mm_add_epi32(sum0, _mm_shuffle_epi32(sum0, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum0 = _mm_add_epi32(sum0, _mm_shuffle_epi32(sum0, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t)_mm_cvtsi128_si32(sum0);
+}
+
+__attribute__((target("avx512f")))
+static uint32_t sub_hash_avx512(const double *scaled, const double *row,
+		const uint32_t *powers, int stride) {
+	__m256i sum = _mm256_setzero_si256();
+	for (int i = 0; i < stride; i += 8) {
+		__m512d v = _mm512_sub_pd(_mm512_loadu_pd(scaled + i), _mm512_load_pd(row + i));
+		v = _mm512_roundscale_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		__m256i p = _mm256_load_si256((const __m256i*)(powers + i));
+		sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm512_cvttpd_epi32(v), p));
+	}
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t)_mm_cvtsi128_si32(half);
+}
+
+#endif
+
+static Sub_Hash_Kernel select_sub_hash_kernel() {
+#ifdef HASH_ENGINE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return sub_hash_avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return sub_hash_avx2;
+	}
+#endif
+	return sub_hash_scalar;
+}
+
+static Sub_Hash_Kernel sub_hash_kernel = select_sub_hash_kernel();
+
+//per thread scratch row of the scaled query, reused across calls so the
+//stride of a large dimension never lands on the stack
+static double* get_scaled_buffer(int stride) {
+	static thread_local vector<double> buffer;
+	if (buffer.size() < (size_t)stride) {
+		buffer.resize(stride);
+	}
+	return buffer.data();
+}
+
+//one candidate bucket of multi-probe, a_j of one sub-hash moved by one
+struct Probe {
+	double score; //distance of the projection to the crossed boundary, in units of w
+	uint32_t code; //(sub-hash*dimension + coordinate)*2 + direction
+};
+
+static bool operator<(const Probe& probe1, const Probe& probe2) {
+	return probe1.score < probe2.score;
+}
+
+//keeps the capacity lowest scores in a max heap
+static void push_probe(Probe *heap, int& size, int capacity, double score, uint32_t code) {
+	if (size < capacity) {
+		heap[size].score = score;
+		heap[size].code = code;
+		size++;
+		push_heap(heap, heap + size);
+	}
+	else if (score < heap[0].score) {
+		pop_heap(heap, heap + size);
+		heap[size - 1].score = score;
+		heap[size - 1].code = code;
+		push_heap(heap, heap + size);
+	}
+}
+
+Hash_Engine::Hash_Engine(int num_of_g, int dimension, int w, int k, unsigned long M, unsigned m) {
+	int per_line = HASH_ENGINE_ALIGNMENT/sizeof(double);
+
+	this->num_of_g = num_of_g;
+	this->dimension = dimension;
+	this->stride = (dimension + per_line - 1)/per_line*per_line;
+	this->k = k;
+	this->bits_of_each_hash = 32/k;
+	this->inverse_w = 1.0/w;
+	this->M = M;
+	this->power_of_two = (M & (M - 1)) == 0;
+	this->mask = (uint32_t)(M - 1);
+
+	size_t bytes = (size_t)num_of_g*k*stride*sizeof(double);
+	this->shifts = (double*)aligned_alloc(HASH_ENGINE_ALIGNMENT, bytes);
+	memset(shifts, 0, bytes);
+
+	this->powers = (uint32_t*)aligned_alloc(HASH_ENGINE_ALIGNMENT,
+		(stride*sizeof(uint32_t) + HASH_ENGINE_ALIGNMENT - 1)/HASH_ENGINE_ALIGNMENT*HASH_ENGINE_ALIGNMENT);
+	for (int i = 0; i < stride; i++) {
+		powers[i] = i < dimension ? pow_mod(m, dimension - 1 - i, M) : 0;
+	}
+}
+
+Hash_Engine::~Hash_Engine() {
+	free(shifts);
+	free(powers);
+}
+
+void Hash_Engine::set_s_array(int g, vector<vector<float>*>& s_array) {
+	for (int i = 0; i < k; i++) {
+		double *row = shifts + (size_t)(g*k + i)*stride;
+		vector<float>& s = *s_array[i];
+		for (int j = 0; j < dimension; j++) {
+			row[j] = s[j]*inverse_w;
+		}
+	}
+}
+
+template <typename T> void Hash_Engine::scale(const T *x, double *scaled) const {
+	int i;
+	for (i = 0; i < dimension; i++) {
+		scaled[i] = x[i]*inverse_w;
+	}
+	for (; i < stride; i++) {
+		scaled[i] = 0;
+	}
+}
+
+unsigned Hash_Engine::sub_hash(const double *scaled, int row_number) const {
+	const double *row = shifts + (size_t)row_number*stride;
+
+	if (power_of_two) {
+		return sub_hash_kernel(scaled, row, powers, stride) & mask;
+	}
+
+	//M is not a power of two (k == 1 in the cube), fall back to 64 bit remainders
+	uint64_t sum = 0;
+	for (int i = 0; i < dimension; i++) {
+		long long a = floor(scaled[i] - row[i]);
+		sum = (sum + mul_mod2(mod(a, M), powers[i], M)) % M;
+	}
+	return sum;
+}
+
+template <typename T> unsigned Hash_Engine::g_hash(const T *x, int g) const {
+	double *scaled = get_scaled_buffer(stride);
+	unsigned total_hash_value = 0;
+
+	scale(x, scaled);
+	for (int i = 0; i < k; i++) {
+		total_hash_value |= sub_hash(scaled, g*k + i) << (32 - (i + 1)*bits_of_each_hash);
+	}
+	return total_hash_value;
+}
+
+template <typename T> void Hash_Engine::g_hash(const T *x, unsigned *g_values) const {
+	double *scaled = get_scaled_buffer(stride);
+
+	scale(x, scaled);
+	for (int g = 0; g < num_of_g; g++) {
+		unsigned total_hash_value = 0;
+		for (int i = 0; i < k; i++) {
+			total_hash_value |= sub_hash(scaled, g*k + i) << (32 - (i + 1)*bits_of_each_hash);
+		}
+		g_values[g] = total_hash_value;
+	}
+}
+
+//h with floor((x_j - s_j)/w) of the given coordinate moved by one
+unsigned Hash_Engine::perturb(unsigned sub_hash_value, int coordinate, bool up) const {
+	if (power_of_two) {
+		return (up ? sub_hash_value + powers[coordinate] : sub_hash_value - powers[coordinate]) & mask;
+	}
+	if (up) {
+		return ((uint64_t)sub_hash_value + powers[coordinate]) % M;
+	}
+	return ((uint64_t)sub_hash_value + M - powers[coordinate]) % M;
+}
+
+//query-directed multi-probe. Besides the g values of x, finds for every g the
+//num_of_probes buckets that x is closest to: one a_j of one sub-hash moves by one,
+//scored by the distance of (x_j - s_j)/w to the boundary it crosses. The probes of
+//g number i go to probe_values[i*num_of_probes ..], closest first. Returns the
+//number of probes of each g, less than asked when the dimension is very small.
+template <typename T>
+int Hash_Engine::g_probe(const T *x, int num_of_probes, unsigned *g_values,
+		unsigned *probe_values) const {
+	num_of_probes = min(num_of_probes, get_max_probes());
+	if (num_of_probes <= 0) {
+		g_hash(x, g_values);
+		return 0;
+	}
+
+	static thread_local vector<Probe> probe_heap;
+	if (probe_heap.size() < (size_t)num_of_probes) {
+		probe_heap.resize(num_of_probes);
+	}
+	Probe *heap = probe_heap.data();
+	double *scaled = get_scaled_buffer(stride);
+	unsigned sub_hashes[k];
+
+	scale(x, scaled);
+	for (int g = 0; g < num_of_g; g++) {
+		unsigned total_hash_value = 0;
+		int size = 0;
+		for (int i = 0; i < k; i++) {
+			const double *row = shifts + (size_t)(g*k + i)*stride;
+			sub_hashes[i] = sub_hash(scaled, g*k + i);
+			total_hash_value |= sub_hashes[i] << (32 - (i + 1)*bits_of_each_hash);
+			for (int j = 0; j < dimension; j++) {
+				double value = scaled[j] - row[j];
+				double fraction = value - floor(value);
+				uint32_t code = (uint32_t)(i*dimension + j) << 1;
+				push_probe(heap, size, num_of_probes, fraction, code);
+				push_probe(heap, size, num_of_probes, 1 - fraction, code | 1);
+			}
+		}
+		g_values[g] = total_hash_value;
+
+		sort_heap(heap, heap + size);
+		unsigned *probes = probe_values + (size_t)g*num_of_probes;
+		for (int p = 0; p < size; p++) {
+			int i = (heap[p].code >> 1)/dimension;
+			int j = (heap[p].code >> 1)%dimension;
+			int shift = 32 - (i + 1)*bits_of_each_hash;
+			unsigned moved = perturb(sub_hashes[i], j, heap[p].code & 1);
+			probes[p] = total_hash_value - (sub_hashes[i] << shift) + (moved << shift);
+		}
+	}
+	return num_of_probes;
+}
+
+#define INSTANTIATE_HASH_ENGINE(T) \
+	template void Hash_Engine::g_hash(const T *x, unsigned *g_values) const; \
+	template unsigned Hash_Engine::g_hash(const T *x, int g) const; \
+	template int Hash_Engine::g_probe(const T *x, int num_of_probes, unsigned *g_values, \
+		unsigned *probe_values) const;
+INSTANTIATE_HASH_ENGINE(double)
+INSTANTIATE_HASH_ENGINE(float)
+INSTANTIATE_HASH_ENGINE(int16_t)
+INSTANTIATE_HASH_ENGINE(uint8_t)
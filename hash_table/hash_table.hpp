@@ -2,6 +2,7 @@
 #define HASH_H
 
 #include <unordered_map>
+#include <vector>
 
 #include "../curve/curve.hpp"
 
@@ -13,12 +14,20 @@ public:
 	~Hash_Table();
 
 	void insert(Content* content, unsigned g_value);
+	void freeze();
+	bool get_bucket(unsigned g_value, Content* const **begin, Content* const **end);
 	void print();
+	bool is_frozen() {return frozen;}
 	unordered_multimap<unsigned, Content*>* get_map();
 	vector<vector<float>*>& get_s_array();
 	int get_dimension() {return dimension;}
 private:
-	unordered_multimap<unsigned, Content*> map;
+	unordered_multimap<unsigned, Content*> map; //until frozen
+	//frozen form: the contents of keys[i] are contents[offsets[i] .. offsets[i+1])
+	vector<unsigned> keys;
+	vector<uint32_t> offsets;
+	vector<Content*> contents;
+	bool frozen;
 	vector<vector<float>*> s_array;
 	int dimension;
 };
@@ -1,6 +1,7 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <algorithm>
 
 using namespace std;
 
@@ -15,6 +16,7 @@ Hash_Table::Hash_Table(int dimension, int w, int k) {
 		s_array.push_back(s);
 	}
 	this->dimension = dimension;
+	this->frozen = false;
 }
 
 Hash_Table::~Hash_Table() {
@@ -27,6 +29,46 @@ void Hash_Table::insert(Content *content, unsigned g_value) {
 	map.insert({g_value, content});
 }
 
+//moves the buckets out of the map into the sorted arrays, after the bulk insert.
+//Inside a bucket the contents keep the order the map walks them in, which for libstdc++
+//is newest first, the same order the equal_range walk of the map gave.
+void Hash_Table::freeze() {
+	vector<pair<unsigned, Content*>> entries(map.begin(), map.end());
+	stable_sort(entries.begin(), entries.end(),
+		[](const pair<unsigned, Content*>& a, const pair<unsigned, Content*>& b) {
+			return a.first < b.first;
+		});
+
+	keys.clear();
+	offsets.clear();
+	contents.clear();
+	contents.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (i == 0 || entries[i].first != entries[i - 1].first) {
+			keys.push_back(entries[i].first);
+			offsets.push_back(i);
+		}
+		contents.push_back(entries[i].second);
+	}
+	offsets.push_back(contents.size());
+
+	unordered_multimap<unsigned, Content*>().swap(map);
+	frozen = true;
+}
+
+bool Hash_Table::get_bucket(unsigned g_value, Content* const **begin, Content* const **end) {
+	vector<unsigned>::iterator it = lower_bound(keys.begin(), keys.end(), g_value);
+	if (it == keys.end() || *it != g_value) {
+		*begin = *end = NULL;
+		return false;
+	}
+
+	size_t bucket = it - keys.begin();
+	*begin = contents.data() + offsets[bucket];
+	*end = contents.data() + offsets[bucket + 1];
+	return true;
+}
+
 unordered_multimap<unsigned, Content*>* Hash_Table::get_map() {
 	return &map;
 }
@@ -38,4 +80,7 @@ void Hash_Table::print() {
 	for (auto it : map) {
 		it.second->print();
 	}
+	for (Content *content : contents) {
+		content->print();
+	}
 }
\ No newline at end of file
@@ -1,24 +1,34 @@
-#ifndef HASH_H
-#define HASH_H
+#ifndef HASH_VECTOR_H
+#define HASH_VECTOR_H
 
 #include <unordered_map>
+#include <vector>
+#include <cstdint>
 
 #include "../curve/curve.hpp"
+#include "../bucket_array/bucket_array.hpp"
+#include "../index_file/index_file.hpp"
 
-typedef Item Content;
-
-class Hash_Table {
+class Hash_Table_Vector {
 public:
-	Hash_Table(int dimension, int w, int k);
-	~Hash_Table();
+	Hash_Table_Vector(int dimension, int w, int k);
+	~Hash_Table_Vector();
 
-	void insert(Content* content, unsigned g_value);
+	void insert(uint32_t id, unsigned g_value);
+	void freeze();
+	void build(vector<pair<unsigned, uint32_t>>& entries);
+	bool get_bucket(unsigned g_value, const uint32_t **begin, const uint32_t **end) const;
+	void save(Index_Writer& writer);
+	bool load(Index_Reader& reader, uint32_t num_of_items);
 	void print();
-	unordered_multimap<unsigned, Content*>* get_map();
+	bool is_frozen() const {return frozen;}
+	unordered_multimap<unsigned, uint32_t>* get_map();
 	vector<vector<float>*>& get_s_array();
 	int get_dimension() {return dimension;}
 private:
-	unordered_multimap<unsigned, Content*> map;
+	unordered_multimap<unsigned, uint32_t> map; //g value -> item id, until frozen
+	Bucket_Array buckets; //frozen form
+	bool frozen;
 	vector<vector<float>*> s_array;
 	int dimension;
 };
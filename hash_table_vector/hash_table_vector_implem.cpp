@@ -1,6 +1,8 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -8,34 +10,75 @@ using namespace std;
 #include "../helping_functions/helping_functions.hpp"
 #include "../hash_table_vector/hash_table_vector.hpp"
 
-Hash_Table::Hash_Table(int dimension, int w, int k) {
+Hash_Table_Vector::Hash_Table_Vector(int dimension, int w, int k) {
 	for (size_t i = 0; i < k; i++){
 		vector<float> *s = new vector<float>;
 		random_float_vector(0, w, *s, dimension);
 		s_array.push_back(s);
 	}
 	this->dimension = dimension;
+	this->frozen = false;
 }
 
-Hash_Table::~Hash_Table() {
+Hash_Table_Vector::~Hash_Table_Vector() {
 	for (size_t i = 0; i < s_array.size(); i++){
 		delete s_array[i];
 	}
 }
 
-void Hash_Table::insert(Content *content, unsigned g_value) {
-	map.insert({g_value, content});
+void Hash_Table_Vector::insert(uint32_t id, unsigned g_value) {
+	map.insert({g_value, id});
 }
 
-unordered_multimap<unsigned, Content*>* Hash_Table::get_map() {
+//moves the buckets out of the map into the sorted arrays, after the bulk insert.
+//Inside a bucket the ids are sorted, so a scan walks the dataset forward.
+void Hash_Table_Vector::freeze() {
+	vector<pair<unsigned, uint32_t>> entries(map.begin(), map.end());
+	unordered_multimap<unsigned, uint32_t>().swap(map);
+	build(entries);
+}
+
+//builds the frozen form straight from (g value, id) pairs, the bulk build of lsh uses it
+void Hash_Table_Vector::build(vector<pair<unsigned, uint32_t>>& entries) {
+	buckets.build(entries);
+	frozen = true;
+}
+
+bool Hash_Table_Vector::get_bucket(unsigned g_value, const uint32_t **begin, const uint32_t **end) const {
+	return buckets.get_bucket(g_value, begin, end);
+}
+
+//the shifts of the h functions and the frozen buckets
+void Hash_Table_Vector::save(Index_Writer& writer) {
+	for (size_t i = 0; i < s_array.size(); i++) {
+		writer.write(s_array[i]->data(), dimension*sizeof(float));
+	}
+	buckets.save(writer);
+}
+
+bool Hash_Table_Vector::load(Index_Reader& reader, uint32_t num_of_items) {
+	for (size_t i = 0; i < s_array.size(); i++) {
+		const float *s = reader.read_array<float>(dimension);
+		if (s == NULL) {
+			return false;
+		}
+		s_array[i]->assign(s, s + dimension);
+	}
+	unordered_multimap<unsigned, uint32_t>().swap(map);
+	frozen = buckets.load(reader, num_of_items);
+	return frozen;
+}
+
+unordered_multimap<unsigned, uint32_t>* Hash_Table_Vector::get_map() {
 	return &map;
 }
-vector<vector<float>*>& Hash_Table::get_s_array() {
+vector<vector<float>*>& Hash_Table_Vector::get_s_array() {
 	return s_array;
 }
 
-void Hash_Table::print() {
+void Hash_Table_Vector::print() {
 	for (auto it : map) {
-		it.second->print();
+		cout <<"("<<it.first<<", "<<it.second<<") "<<endl;
 	}
+	buckets.print();
 }
\ No newline at end of file
@@ -11,6 +11,9 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <ctime>
+#include <thread>
+#include <getopt.h>
 
 using namespace std;
 
@@ -21,10 +24,11 @@ using namespace std;
 #include "../query_result/query_result.hpp"
 #include "../helping_functions/helping_functions.hpp"
 #include "../Tuple/tuple.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../text_file/text_file.hpp"
 
 std::random_device rd;  //Will be used to obtain a seed for the random number engine
 std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-std::uniform_int_distribution<> dis(0, 1);
 
 void convert_2d_curve_to_vector_by_projection(vector<Tuple*>& traversal, int U_or_V, double **G_matrix, Curve *curve,
 		int G_rows, int G_cols, Item **item) {
@@ -38,7 +42,7 @@ void matrix_multiplication(vector<Tuple*>& traversal, int U_or_V, double **G_mat
 	int position_of_curve;
 	vector<double> *results_points;
 
-	vector<Point*>points = curve->get_points();
+	const Type *points = curve->get_xy();
 	results_points = new vector<double>;
 	for (size_t U_i = 0; U_i < traversal.size(); U_i++) {
 		for(int i = 0; i < G_rows; ++i) { //for every row of G
@@ -46,7 +50,7 @@ void matrix_multiplication(vector<Tuple*>& traversal, int U_or_V, double **G_mat
 				sum = 0.0;
             	for(int k = 0; k < G_cols; ++k) {
 					position_of_curve = traversal[U_i]->get_coord(U_or_V);
-					sum += G_matrix[i][k] * points[position_of_curve]->get_coord(k);
+					sum += G_matrix[i][k] * points[2*position_of_curve + k];
 				}
 				results_points->push_back(sum);
             }
@@ -64,12 +68,65 @@ void convert_2d_curve_to_vector(Curve *curve, Point *t, double delta, int dimens
 	(*grid_curve)->set_corresponding_curve(curve);
 }
 
+//the long options, getopt_long_only still takes the short ones
+#define SAVE_INDEX_OPTION 256
+#define LOAD_INDEX_OPTION 257
+#define EXACT_OPTION 258
+#define GROUND_TRUTH_OPTION 259
+#define ELEMENT_TYPE_OPTION 260
+#define BALANCED_OPTION 261
+static struct option hypercube_long_options[] = {
+	{"threads", required_argument, NULL, 't'},
+	{"type", required_argument, NULL, ELEMENT_TYPE_OPTION}, //read by read_element_type
+	{"save-index", required_argument, NULL, SAVE_INDEX_OPTION},
+	{"load-index", required_argument, NULL, LOAD_INDEX_OPTION},
+	{"exact", no_argument, NULL, EXACT_OPTION},
+	{"gt", required_argument, NULL, GROUND_TRUTH_OPTION},
+	{"balanced", no_argument, NULL, BALANCED_OPTION},
+	{NULL, 0, NULL, 0}
+};
+
+//element type of the vectors: the -type option, else the one of a binary input file,
+//else double. 0 when -type names no element type.
+uint32_t read_element_type(char *argv[], int argc) {
+	string input_file = "";
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "-type") == 0) {
+			return get_element_type(argv[i + 1]);
+		}
+		if (strcmp(argv[i], "-d") == 0) {
+			input_file = argv[i + 1];
+		}
+	}
+	uint32_t element_type = input_file == "" ? 0 : get_dataset_file_element_type(input_file);
+	return element_type != 0 ? element_type : DATASET_FILE_DOUBLE;
+}
+
 void read_command_line_arguments_hypercube(char *argv[], int& argc,string& input_file, string& query_file,
-	string& output_file, int& k, int& M,int& probes,int &flag){
+	string& output_file, int& k, int& M,int& probes,int& L,int &flag,string& save_index_file,
+	string& load_index_file,int& threads,bool& exact,bool& balanced,string& ground_truth_file){
 	int opt;
-	while((opt = getopt(argc, argv, "d:q:o:k:M:p:")) != -1)
+	while((opt = getopt_long_only(argc, argv, "d:q:o:k:M:p:L:", hypercube_long_options, NULL)) != -1)
     {
       switch(opt){
+          case 't':
+            	threads= atoi(optarg);
+          break;
+          case EXACT_OPTION:
+            	exact= true;
+          break;
+          case BALANCED_OPTION:
+            	balanced= true;
+          break;
+          case GROUND_TRUTH_OPTION:
+            	ground_truth_file= optarg;
+          break;
+          case SAVE_INDEX_OPTION:
+            	save_index_file= optarg;
+          break;
+          case LOAD_INDEX_OPTION:
+            	load_index_file= optarg;
+          break;
           case 'd':
             	input_file= optarg;
           break;
@@ -90,17 +147,27 @@ void read_command_line_arguments_hypercube(char *argv[], int& argc,string& input
           case 'p':
 		  		probes=atoi(optarg);
           break;
+          case 'L':
+		  		L=atoi(optarg);
+          break;
       }
   }
 
 }
 
 void read_command_line_arguments_hypercube_grid(char *argv[], int& argc,string& input_file, string& query_file,
-	string& output_file, int& k, int& M,int& probes,int &L,double &delta,int &flag ){
+	string& output_file, int& k, int& M,int& probes,int &L,double &delta,int &flag,int& threads,
+	string& ground_truth_file){
 	int opt;
-	while((opt = getopt(argc, argv, "d:q:o:k:M:p:L:D:")) != -1)
+	while((opt = getopt_long_only(argc, argv, "d:q:o:k:M:p:L:D:", hypercube_long_options, NULL)) != -1)
     {
       switch(opt){
+          case 't':
+            	threads= atoi(optarg);
+          break;
+          case GROUND_TRUTH_OPTION:
+            	ground_truth_file= optarg;
+          break;
           case 'd':
             	input_file= optarg;
           break;
@@ -133,11 +200,18 @@ void read_command_line_arguments_hypercube_grid(char *argv[], int& argc,string&
 
 }
 
-void read_command_line_arguments_hypercube_projection(char* argv[],int &argc,string &input_file,string &query_file,int& k, int& M,int & probes,double &e,string &output_file,int &flag ){
+void read_command_line_arguments_hypercube_projection(char* argv[],int &argc,string &input_file,string &query_file,int& k, int& M,int & probes,double &e,string &output_file,int &flag,int& threads,
+	string& ground_truth_file){
 	int opt;
-	while((opt = getopt(argc, argv, "d:q:o:k:M:p:e:")) != -1)
+	while((opt = getopt_long_only(argc, argv, "d:q:o:k:M:p:e:", hypercube_long_options, NULL)) != -1)
     {
       switch(opt){
+          case 't':
+            	threads= atoi(optarg);
+          break;
+          case GROUND_TRUTH_OPTION:
+            	ground_truth_file= optarg;
+          break;
           case 'd':
             	input_file= optarg;
           break;
@@ -166,44 +240,44 @@ void read_command_line_arguments_hypercube_projection(char* argv[],int &argc,str
 
 }
 
-unsigned f_hash_function(vector<Type> x , int dimension,int w, int k,
-	int bits_of_each_hash, unsigned M, vector<unsigned>& m_powers,vector<vector<float>*>& s_array,vector< unordered_map<unsigned,int> *>&g_value,int f){
-	int y;
-	srand(time(0));
+uint64_t random_f_seed() {
+	return ((uint64_t)gen() << 32) | gen();
+}
+
+unsigned f_hash_function(const Type *x, int dimension,int w, int k,
+	int bits_of_each_hash, unsigned M, vector<unsigned>& m_powers,vector<vector<float>*>& s_array,uint64_t seed){
 	unsigned g;
-	g=0;
 	g=g_hash_function(x , dimension, w,  k,bits_of_each_hash,  M,s_array,m_powers);
-	if(g_value[f]->find(g) == g_value[f]->end()){// not found
-		y=dis(gen);
-		g_value[f]->insert(make_pair(g,y));
-		return y;
-	}
-	else{
-		return g_value[f]->find(g)->second;
-	}
+	return f_hash_function(g,seed);
+}
+
+//the splitmix64 finalizer of the g value keyed by the seed, its top bit is the coin flip
+unsigned f_hash_function(unsigned g, uint64_t seed){
+	uint64_t z = seed + (g + 1)*0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+	z = z ^ (z >> 31);
+	return z >> 63;
 }
 
 void snap_curve(Curve *curve, Point *t, Curve **grid_curve, float delta) {
 
-	Point *snapped_point = NULL;
+	Type x, y;
 
-	vector<Point*> *snapped_points = new vector<Point*>;
-	for(Point *point : curve->get_points() ) {
-		get_snapped_point(point, delta, t, &snapped_point);
+	*grid_curve = new Curve(curve->get_name(), curve->get_length());
+	for (int i = 0; i < curve->get_length(); i++) {
+		get_snapped_point(curve->get_x(i), curve->get_y(i), delta, t, x, y);
 		//consecutive duplicate
-		if (snapped_points->size() > 0) {
-			if (snapped_points->back()->equals(snapped_point) == true) {
-				delete snapped_point;
-				continue;
-			}
+		int length = (*grid_curve)->get_length();
+		if (length > 0 && (*grid_curve)->get_x(length - 1) == x && (*grid_curve)->get_y(length - 1) == y) {
+			continue;
 		}
-		snapped_points->push_back(snapped_point);
+		(*grid_curve)->insert_point(x, y);
 	}
-	*grid_curve = new Curve(curve->get_name(), snapped_points);
 
 }
 
-void get_snapped_point(Point *point, float delta, Point *t, Point **snapped_point) {
+void get_snapped_point(Type x, Type y, float delta, Point *t, Type& snapped_x, Type& snapped_y) {
 	/*
 			one cell, shifted by t, of the big Grid
 		up_left -------------- up_right
@@ -214,25 +288,19 @@ void get_snapped_point(Point *point, float delta, Point *t, Point **snapped_poin
 		down_left ------------- down_left
 	*/
 
-	double best_x = round( (point->get_x() - t->get_x())/delta)*delta + t->get_x();
-	double best_y = round( (point->get_y() - t->get_y())/delta)*delta + t->get_y();
-
-	*snapped_point = new Point(best_x, best_y);
+	snapped_x = round( (x - t->get_x())/delta)*delta + t->get_x();
+	snapped_y = round( (y - t->get_y())/delta)*delta + t->get_y();
 }
 
 void fill_curve(Curve *curve, int pad_length) {
 	for (size_t i = 0; i < pad_length; i++) {
-		Point *point = new Point(60, 60);
-		curve->insert_point(point);
+		curve->insert_point(60, 60);
 	}
 }
 
 void zip_points(Curve *grid_curve, Item **item) {
-	vector<Type> *coordinates = new vector<Type>;
-	for(Point *point : grid_curve->get_points() ) {
-		coordinates->push_back(point->get_x());
-		coordinates->push_back(point->get_y());
-	}
+	const Type *xy = grid_curve->get_xy();
+	vector<Type> *coordinates = new vector<Type>(xy, xy + 2*grid_curve->get_length());
 
 	*item = new Item(coordinates);
 }
@@ -329,7 +397,8 @@ void random_matrix(int K, int d, double **G, float mean, float deviation ) {
 }
 
 void read_command_line_arguments(char *argv[], int& argc, string& input_file, string& query_file,
-	string& output_file, int& k, int& L, int& w, int& st, float& eps, int& M_table) {
+	string& output_file, int& k, int& L, int& w, int& st, float& eps, int& M_table, int& threads,
+	string& ground_truth_file) {
 	for (int i = 1; i < argc; i++) {
 		if (strcmp(argv[i], "-d") == 0) {
 			input_file = argv[i + 1];
@@ -358,11 +427,18 @@ void read_command_line_arguments(char *argv[], int& argc, string& input_file, st
 		else if (strcmp(argv[i], "-M") == 0) {
 			M_table = atoi(argv[i + 1]);
 		}
+		else if (strcmp(argv[i], "-threads") == 0) {
+			threads = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-gt") == 0) {
+			ground_truth_file = argv[i + 1];
+		}
 	}
 }
 
 void read_command_line_arguments(char *argv[], int& argc, string& input_file, string& query_file,
-	string& output_file, int& k, int& L, int& w, int& st, bool& check_for_identical_grid_flag, float& delta) {
+	string& output_file, int& k, int& L, int& w, int& st, bool& check_for_identical_grid_flag, float& delta, int& threads,
+	string& ground_truth_file) {
 	for (int i = 1; i < argc; i++) {
 		if (strcmp(argv[i], "-d") == 0) {
 			input_file = argv[i + 1];
@@ -391,11 +467,19 @@ void read_command_line_arguments(char *argv[], int& argc, string& input_file, st
 		else if (strcmp(argv[i], "--delta") == 0) {
 			delta = atof(argv[i + 1]);
 		}
+		else if (strcmp(argv[i], "-threads") == 0) {
+			threads = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-gt") == 0) {
+			ground_truth_file = argv[i + 1];
+		}
 	}
 }
 
 void read_command_line_arguments(char *argv[], int& argc, string& input_file, string& query_file,
-	string& output_file, int& k, int& L, int& w, int& st) {
+	string& output_file, int& k, int& L, int& w, int& st, int& probes, int& neighbours,
+	string& save_index_file, string& load_index_file, int& threads, bool& exact,
+	string& ground_truth_file, int& w_samples) {
 	for (int i = 1; i < argc; i++) {
 		if (strcmp(argv[i], "-d") == 0) {
 			input_file = argv[i + 1];
@@ -418,6 +502,30 @@ void read_command_line_arguments(char *argv[], int& argc, string& input_file, st
 		else if (strcmp(argv[i], "-st") == 0) {
 			st = atoi(argv[i + 1]);
 		}
+		else if (strcmp(argv[i], "-probes") == 0) {
+			probes = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-kNN") == 0) {
+			neighbours = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--save-index") == 0) {
+			save_index_file = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--load-index") == 0) {
+			load_index_file = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-threads") == 0) {
+			threads = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-exact") == 0) {
+			exact = true;
+		}
+		else if (strcmp(argv[i], "-w_samples") == 0) {
+			w_samples = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-gt") == 0) {
+			ground_truth_file = argv[i + 1];
+		}
 	}
 }
 
@@ -427,85 +535,95 @@ void delete_curves(list<Curve*> curves) {
 	}
 }
 
-int read_2d_curves_from_file(string file_name, list<Curve*>& curves, int& max_length, int M_table) {
-	string line, coordinate, name, tuple, part1, part2;
-	int length;
-	double x, y;
-	Point *point;
-	Curve *curve;
-	vector<Point*> *points;
+//one "(x, y)" of a curve line, false at the end of the line
+static bool parse_2d_point(const char*& p, const char *end, double& x, double& y) {
+	p = skip_spaces(p, end);
+	if (p == end || *p != '(') {
+		return false;
+	}
+	p++;
+	if (parse_number(p, end, x) == false) {
+		return false;
+	}
+	p = skip_spaces(p, end);
+	if (p < end && *p == ',') {
+		p++;
+	}
+	if (parse_number(p, end, y) == false) {
+		return false;
+	}
+	p = skip_spaces(p, end);
+	if (p < end && *p == ')') {
+		p++;
+	}
+	return true;
+}
 
-	ifstream inputfile(file_name.c_str());
-	if (inputfile.is_open() == false) {
+//parses the chunks of a curve file in parallel, the curves keep the order of the file.
+//Curves longer than M_table are skipped.
+static int parse_2d_curves(string file_name, list<Curve*>& curves, int& max_length, int M_table,
+		double& max_coord) {
+	Text_File file;
+	if (file.open(file_name) == false) {
 		cout <<"File opening error: "<<file_name<<endl;
 		return 1;
 	}
-	else {
-		max_length = -1;
-		while(getline(inputfile, line)) {
-			istringstream iss (line);
-			iss >> name;
-			iss >> length;
+
+	vector<const char*> bounds;
+	int threads = max(1u, thread::hardware_concurrency());
+	file.split(4*threads, bounds);
+	uint32_t num_of_chunks = bounds.size() - 1;
+	vector<vector<Curve*>> chunk_curves(num_of_chunks);
+	vector<int> max_lengths(num_of_chunks, -1);
+	vector<double> max_coords(num_of_chunks, max_coord);
+	Thread_Pool thread_pool(min((uint32_t)threads, max(num_of_chunks, 1u)));
+
+	thread_pool.run(num_of_chunks, [&](uint32_t chunk) {
+		const char *chunk_end = bounds[chunk + 1];
+		for (const char *p = bounds[chunk]; p < chunk_end; p = next_line(p, chunk_end)) {
+			const char *name;
+			size_t name_length;
+			const char *values = parse_word(p, chunk_end, name, name_length);
+			int length = 0;
+			double x, y;
+			if (name_length == 0) {
+				continue;
+			}
+			parse_number(values, chunk_end, length);
 			if (length > M_table) {
-				iss.ignore();
 				continue;
 			}
-			max_length = max(max_length, length);
-
-			points = new vector<Point*>;
-			while ( iss >> part1 >> part2) {
-				tuple = part1 + part2;
-				sscanf(tuple.c_str(), "(%lf, %lf)", &x, &y);
-				point = new Point();
-				point->insert_coordinate(x);
-				point->insert_coordinate(y);
-				points->push_back(point);
+			max_lengths[chunk] = max(max_lengths[chunk], length);
+
+			//the points go straight into the xy array of the curve, reserved from the length
+			Curve *curve = new Curve(string(name, name_length), length);
+			while (parse_2d_point(values, chunk_end, x, y)) {
+				max_coords[chunk] = max(max(x, y), max_coords[chunk]);
+				curve->insert_point(x, y);
 			}
-			curve = new Curve(name, points);
+			chunk_curves[chunk].push_back(curve);
+		}
+	});
+
+	max_length = -1;
+	for (uint32_t chunk = 0; chunk < num_of_chunks; chunk++) {
+		max_length = max(max_length, max_lengths[chunk]);
+		max_coord = max(max_coord, max_coords[chunk]);
+		for (Curve *curve : chunk_curves[chunk]) {
+			curve->set_id(curves.size());
 			curves.push_back(curve);
 		}
-		inputfile.close();
 	}
 	return 0;
 }
 
-int read_2d_curves_from_file(string file_name, list<Curve*>& curves, int& max_length, double& max_coord) {
-	string line, coordinate, name, tuple, part1, part2;
-	int length;
-	double x, y;
-	Point *point;
-	Curve *curve;
-	vector<Point*> *points;
+int read_2d_curves_from_file(string file_name, list<Curve*>& curves, int& max_length, int M_table) {
+	double max_coord = numeric_limits<double>::lowest();
+	return parse_2d_curves(file_name, curves, max_length, M_table, max_coord);
+}
 
-	ifstream inputfile(file_name.c_str());
-	if (inputfile.is_open() == false) {
-		cout <<"File opening error: "<<file_name<<endl;
-		return 1;
-	}
-	else {
-		max_length = -1;
-		while(getline(inputfile, line)) {
-			istringstream iss (line);
-			iss >> name;
-			iss >> length;
-			max_length = max(max_length, length);
-
-			points = new vector<Point*>;
-			while ( iss >> part1 >> part2) {
-				tuple = part1 + part2;
-				sscanf(tuple.c_str(), "(%lf, %lf)", &x, &y);
-				max_coord = max(max(x, y), max_coord);
-				point = new Point();
-				point->insert_coordinate(x);
-				point->insert_coordinate(y);
-				points->push_back(point);
-			}
-			curve = new Curve(name, points);
-			curves.push_back(curve);
-		}
-		inputfile.close();
-	}
-	return 0;
+int read_2d_curves_from_file(string file_name, list<Curve*>& curves, int& max_length, double& max_coord) {
+	return parse_2d_curves(file_name, curves, max_length, numeric_limits<int>::max(), max_coord);
 }
 
 void print_curves(list<Curve*> curves)  {
@@ -515,59 +633,43 @@ void print_curves(list<Curve*> curves)  {
 	}
 }
 
-void print_range_results(list<Item*> items, float radious)  {
+template <typename T>
+void print_range_results(list<uint32_t> items, Dataset<T> *dataset, float radious)  {
 	//cout <<"R-near neighbors :"<<radious<<endl;
-	for (Item *item : items) {
-		cout << item->get_name();
+	for (uint32_t id : items) {
+		cout << dataset->get_name(id);
 		cout <<endl;
 	}
 }
-void print_range_results_to_file(list<Item*> items,FILE *out ,float range){
+template <typename T>
+void print_range_results_to_file(list<uint32_t> items, Dataset<T> *dataset, FILE *out, float range){
 	//fprintf(out,"R-near neighbors : %lf", range);
-	for (Item *item : items)
-		fprintf(out,  "%s\n",   item->get_name().c_str() );
+	for (uint32_t id : items)
+		fprintf(out,  "%s\n",   dataset->get_name(id).c_str() );
 }
 
-double DTW(vector<Point*>& p, vector<Point*>& q) {
-	int m1 = p.size();
-	int m2 = q.size();
+#define INSTANTIATE_PRINT_RANGE_RESULTS(T) \
+	template void print_range_results(list<uint32_t> items, Dataset<T> *dataset, float range); \
+	template void print_range_results_to_file(list<uint32_t> items, Dataset<T> *dataset, FILE *out, float range);
+INSTANTIATE_PRINT_RANGE_RESULTS(double)
+INSTANTIATE_PRINT_RANGE_RESULTS(float)
+INSTANTIATE_PRINT_RANGE_RESULTS(int16_t)
+INSTANTIATE_PRINT_RANGE_RESULTS(uint8_t)
 
-	double dtw_array[m1][m2];
-
-	//initialize (0,0) point of the array
-	dtw_array[0][0] = euclidean_distance_2d(p[0], q[0]);
-
-
-	//initialize first row of the array
-	for (size_t j = 1; j < m2; j++) {
-		dtw_array[0][j] = euclidean_distance_2d( p[0], q[j] ) + dtw_array[0][j - 1];
-	}
-
-	//initialize first column of the array
-	for (size_t i = 1; i < m1; i++) {
-		dtw_array[i][0] = euclidean_distance_2d( p[i], q[0] ) + dtw_array[i - 1][0];
-	}
-
-	//calculate the rest cells of the array( (1,1) is calculated twice, but that's ok )
-	for (size_t i = 1; i < m1; i++) {
-		for (size_t j = 1; j < m2; j++) {
-			dtw_array[i][j] = euclidean_distance_2d( p[i], q[j] ) +
-				min({dtw_array[i - 1][j - 1], dtw_array[i][j - 1], dtw_array[i - 1][j]});
-		}
-	}
-	return dtw_array[m1 - 1][m2 - 1];
+//the DTW of the flat xy arrays of the curves, two rows at a time
+double DTW(Curve *curve1, Curve *curve2) {
+	return dtw_distance(curve1->get_xy(), curve1->get_length(), curve2->get_xy(), curve2->get_length());
 }
 
 double manhattan_distance_2d(Point *p, Point *q) {
 	return abs(p->get_x() - q->get_x()) + abs(p->get_y() - q->get_y());
 }
 
-double euclidean_distance_2d(Point *p, Point *q) {
-	return sqrt( (p->get_x() - q->get_x())*(p->get_x() - q->get_x() ) +
-	(p->get_y() - q->get_y())*(p->get_y() - q->get_y()) );
+double euclidean_distance_2d(const Type *p, const Type *q) {
+	return sqrt( (p[0] - q[0])*(p[0] - q[0]) + (p[1] - q[1])*(p[1] - q[1]) );
 }
 
-unsigned g_hash_function(vector<Type> x , int dimension, int w, int k,
+unsigned g_hash_function(const Type *x, int dimension, int w, int k,
 	int bits_of_each_hash, unsigned M, vector<vector<float>*>& s_array, vector<unsigned>& m_powers) {
 
 	unsigned hash_value, total_hash_value = 0;
@@ -580,7 +682,7 @@ unsigned g_hash_function(vector<Type> x , int dimension, int w, int k,
 	return total_hash_value;
 }
 
-unsigned hash_function(vector<Type> x, int dimension, int w, unsigned M,
+unsigned hash_function(const Type *x, int dimension, int w, unsigned M,
 	vector<float>& s, vector<unsigned>& m_powers) {
 
 	vector<int> a;
@@ -694,90 +796,148 @@ void get_vector_from_line(string line, Item& item) {
 	item.set_coordinates(coordinates);
 }
 
-void read_vectors_from_file(string file_name, list<Item*>& items) {
-	string line, name;
-	Type coordinate;
+template <typename T> void read_vectors_from_file(string file_name, Dataset<T>& items) {
+	float radious = -1;
+	read_vectors_from_file(file_name, items, radious);
+}
 
-	ifstream inputfile(file_name.c_str());
-	if (inputfile.is_open() == false) {
-		cout <<"File opening error: "<<file_name<<endl;
-		return;
-	}
-	else {
-		while(getline(inputfile, line)) {
-			istringstream iss (line);
-			iss >> name;
-			vector<Type> *coordinates = new vector<Type>;
-			while ( iss >> coordinate ) {
-				coordinates->push_back(coordinate);
-			}
-			Item *item = new Item(name, coordinates);
-			items.push_back(item);
-		}
-		inputfile.close();
-	}
-	return;
+//a line of a vector file, not a blank one or the Radius line of a query file
+static bool is_vector_line(const char *word, size_t length) {
+	return length != 0 && (length != 7 || memcmp(word, "Radius:", 7) != 0);
 }
 
-void read_vectors_from_file(string file_name, list<Item*>& items, float& radious) {
-	string line, name;
-	Type coordinate;
+//the numbers are parsed as doubles and converted to T, so integer rows round them
+template <typename T> void read_vectors_from_file(string file_name, Dataset<T>& items, float& radious) {
+	double coordinate;
 
-	ifstream inputfile(file_name.c_str());
-	if (inputfile.is_open() == false) {
+	//binary dataset files are mapped, not parsed
+	if (is_dataset_file(file_name)) {
+		float file_radious;
+		if (items.load(file_name, file_radious) == false) {
+			cout <<"Dataset file reading error: "<<file_name<<endl;
+		}
+		else if (file_radious != -1) {
+			radious = file_radious;
+		}
+		return;
+	}
+
+	Text_File file;
+	if (file.open(file_name) == false) {
 		cout <<"File opening error: "<<file_name<<endl;
 		return;
 	}
-	else {
-		while(getline(inputfile, line)) {
-			istringstream iss (line);
-			iss >> name;
-			if (name == "Radius:") {
-				iss >> radious;
-				continue;
-			}
-			vector<Type> *coordinates = new vector<Type>;
-			while ( iss >> coordinate ) {
-				coordinates->push_back(coordinate);
+	const char *end = file.get_end();
+
+	//the dimension of a new dataset comes from its first vector
+	if (items.get_dimension() == 0) {
+		for (const char *p = file.get_begin(); p < end; p = next_line(p, end)) {
+			const char *word;
+			size_t length;
+			const char *values = parse_word(p, end, word, length);
+			if (is_vector_line(word, length)) {
+				int dimension = 0;
+				while (parse_number(values, end, coordinate)) {
+					dimension++;
+				}
+				items.set_dimension(dimension);
+				break;
 			}
-			Item *item = new Item(name, coordinates);
-			items.push_back(item);
 		}
-		inputfile.close();
+		if (items.get_dimension() == 0) {
+			return;
+		}
 	}
-	return;
-}
-
-unsigned long long int manhattan_distance(vector<Type> x1, vector<Type> x2) {
-
-	unsigned long long int sum = 0;
-	for (size_t i = 0; i < x1.size(); i++) {
-		sum += abs(x1[i] - x2[i]);
+	int dimension = items.get_dimension();
+
+	//the chunks are parsed twice, first to count the vectors and the characters of
+	//their names, then straight into the rows that the counts reserve
+	vector<const char*> bounds;
+	int threads = max(1u, thread::hardware_concurrency());
+	file.split(4*threads, bounds);
+	uint32_t num_of_chunks = bounds.size() - 1;
+	vector<uint32_t> lines(num_of_chunks + 1, 0);
+	vector<uint64_t> name_bytes(num_of_chunks + 1, 0);
+	vector<float> radiouses(num_of_chunks, -1);
+	Thread_Pool thread_pool(min((uint32_t)threads, max(num_of_chunks, 1u)));
+
+	thread_pool.run(num_of_chunks, [&](uint32_t chunk) {
+		const char *chunk_end = bounds[chunk + 1];
+		for (const char *p = bounds[chunk]; p < chunk_end; p = next_line(p, chunk_end)) {
+			const char *word;
+			size_t length;
+			const char *values = parse_word(p, chunk_end, word, length);
+			if (is_vector_line(word, length)) {
+				lines[chunk + 1]++;
+				name_bytes[chunk + 1] += length;
+			}
+			else if (length != 0) {
+				parse_number(values, chunk_end, radiouses[chunk]);
+			}
+		}
+	});
+	for (uint32_t chunk = 0; chunk < num_of_chunks; chunk++) {
+		lines[chunk + 1] += lines[chunk];
+		name_bytes[chunk + 1] += name_bytes[chunk];
+		if (radiouses[chunk] != -1) {
+			radious = radiouses[chunk];
+		}
 	}
 
-	return sum;
+	uint64_t name_position = items.get_name_bytes();
+	uint32_t first = items.grow(lines[num_of_chunks], name_bytes[num_of_chunks]);
+	thread_pool.run(num_of_chunks, [&](uint32_t chunk) {
+		const char *chunk_end = bounds[chunk + 1];
+		uint32_t id = first + lines[chunk];
+		uint64_t position = name_position + name_bytes[chunk];
+		for (const char *p = bounds[chunk]; p < chunk_end; p = next_line(p, chunk_end)) {
+			const char *word;
+			size_t length;
+			const char *values = parse_word(p, chunk_end, word, length);
+			if (is_vector_line(word, length) == false) {
+				continue;
+			}
+			items.set_name(id, position, word, length);
+			position += length;
+
+			//shorter rows stay zero padded, longer ones are cut to the dataset dimension
+			T *row = items.get_row(id);
+			int i = 0;
+			while (i < dimension && parse_number(values, chunk_end, coordinate)) {
+				row[i++] = to_element<T>(coordinate);
+			}
+			id++;
+		}
+	});
 }
 
+#define INSTANTIATE_READ_VECTORS(T) \
+	template void read_vectors_from_file(string file_name, Dataset<T>& items); \
+	template void read_vectors_from_file(string file_name, Dataset<T>& items, float& range);
+INSTANTIATE_READ_VECTORS(double)
+INSTANTIATE_READ_VECTORS(float)
+INSTANTIATE_READ_VECTORS(int16_t)
+INSTANTIATE_READ_VECTORS(uint8_t)
 
 void exhaustive_curve_search(list<Curve*> *curves, Curve *query, Query_Result& query_result) {
 	double best_distance = numeric_limits<double>::max();
-	string best = "";
+	Curve *best = NULL;
 
-	time_t time;
-	time = clock();
+	double time;
+	time = get_thread_time();
 	for (Curve *curve : *curves) {
-		double cur_distance = DTW(query->get_points(), curve->get_points());
+		double cur_distance = DTW(query, curve);
 		if (cur_distance < best_distance) {
-			best = curve->get_name();
+			best = curve;
 			best_distance = cur_distance;
 		}
 	}
-	time = clock() - time;
+	time = get_thread_time() - time;
 
-	if (best != "") {
+	if (best != NULL) {
 		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+		query_result.set_time(time);
+		query_result.set_best_item(best->get_name());
 	}
 	else {
 		query_result.set_best_distance(-1);
@@ -786,27 +946,26 @@ void exhaustive_curve_search(list<Curve*> *curves, Curve *query, Query_Result& q
 	}
 }
 
+//exact capacity of neighbours nearest curves, the ground truth of recall@k
+void exhaustive_curve_search_k(list<Curve*> *curves, Curve *query, KNN_Heap& neighbours) {
+	for (Curve *curve : *curves) {
+		neighbours.push(curve->get_id(), DTW(query, curve));
+	}
+}
 
-void exhaustive_search(list<Item*> *items, Item *query, Query_Result& query_result) {
-
-	unsigned best_distance = numeric_limits<unsigned>::max();
-	string best = "-";
+template <typename T>
+void exhaustive_search(Dataset<T> *items, const T *query, Query_Result& query_result) {
+	KNN_Heap neighbours(1);
 
-	time_t time;
-	time = clock();
-	for (Item *item : *items) {
-		unsigned cur_distance = manhattan_distance(*(query->get_coordinates()), *(item->get_coordinates()) );
-		if (cur_distance < best_distance) {
-			best = item->get_name();
-			best_distance = cur_distance;
-		}
-	}
-	time = clock() - time;
+	double time;
+	time = get_thread_time();
+	exhaustive_search_k(items, query, neighbours);
+	time = get_thread_time() - time;
 
-	if (best != "-") {
-		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(items->get_name(neighbours.get_neighbour(0).id));
 	}
 	else {
 		query_result.set_best_distance(-1);
@@ -815,6 +974,42 @@ void exhaustive_search(list<Item*> *items, Item *query, Query_Result& query_resu
 	}
 }
 
+//exact capacity of neighbours nearest items, the ground truth of recall@k
+template <typename T>
+void exhaustive_search_k(Dataset<T> *items, const T *query, KNN_Heap& neighbours) {
+	int dimension = items->get_dimension();
+	for (uint32_t id = 0; id < items->get_size(); id++) {
+		double cur_distance = manhattan_distance(query, items->get_coordinates(id), dimension,
+			neighbours.get_threshold());
+		neighbours.push(id, cur_distance);
+	}
+}
+
+#define INSTANTIATE_EXHAUSTIVE_SEARCH(T) \
+	template void exhaustive_search(Dataset<T> *items, const T *query, Query_Result& query_result); \
+	template void exhaustive_search_k(Dataset<T> *items, const T *query, KNN_Heap& neighbours);
+INSTANTIATE_EXHAUSTIVE_SEARCH(double)
+INSTANTIATE_EXHAUSTIVE_SEARCH(float)
+INSTANTIATE_EXHAUSTIVE_SEARCH(int16_t)
+INSTANTIATE_EXHAUSTIVE_SEARCH(uint8_t)
+
+//fraction of the exact neighbours that the approximate search found too
+double recall(KNN_Heap& approximate, KNN_Heap& exact) {
+	int found = 0;
+	if (exact.get_size() == 0) {
+		return 1;
+	}
+	for (int i = 0; i < exact.get_size(); i++) {
+		for (int j = 0; j < approximate.get_size(); j++) {
+			if (approximate.get_neighbour(j).id == exact.get_neighbour(i).id) {
+				found++;
+				break;
+			}
+		}
+	}
+	return (double)found/exact.get_size();
+}
+
 void delete_items(list<Item*> items) {
 	for (Item *item : items) {
 		delete item;
@@ -822,6 +1017,19 @@ void delete_items(list<Item*> items) {
 }
 
 
+//cpu seconds spent by the calling thread, so queries answered in parallel time only themselves
+double get_thread_time() {
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec/1e9;
+}
+
+double get_wall_time() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec/1e9;
+}
+
 unsigned mod(long long a, long long b) {
 	return (a%b + b)%b;
 }
@@ -914,6 +1122,16 @@ int find_dimension_from_file(string file_name) {
 	string line, word;
 	int counter;
 
+	if (is_dataset_file(file_name)) {
+		Dataset<Type> items;
+		float radious;
+		if (items.load(file_name, radious) == false) {
+			cout <<"Dataset file reading error: "<<file_name<<endl;
+			return 1;
+		}
+		return items.get_dimension();
+	}
+
 	ifstream inputfile(file_name.c_str());
 	if (inputfile.is_open() == false) {
 		cout <<"File opening error: "<<file_name<<endl;
@@ -1124,70 +1342,27 @@ double calculate_delta(list<Curve*> curves) {
 
 	double total_sum = 0;
 	for (Curve *curve : curves) {
-		vector<Point*> points = curve->get_points();
+		const Type *points = curve->get_xy();
+		int length = curve->get_length();
 		double sum = 0;
-		for (size_t i = 0; i < points.size() - 1; i++) {
-			sum += euclidean_distance_2d(points[i], points[i + 1]);
+		for (int i = 0; i < length - 1; i++) {
+			sum += euclidean_distance_2d(points + 2*i, points + 2*(i + 1));
 
 		}
-		if (points.size() != 1) {
-			total_sum += sum/(points.size() - 1);
+		if (length != 1) {
+			total_sum += sum/(length - 1);
 		}
 	}
 	return total_sum/curves.size();
 }
 
-int calculate_w(list<Item*> items) {
-	double cur_distance;
-	double best_distance = numeric_limits<double>::max();
-
-	double sum = 0;
-	for(Item *item1 : items) {
-
-		for(Item *item2 : items) {
-			cur_distance = manhattan_distance(*(item1->get_coordinates()),
-				(*item2->get_coordinates()));
-			if (cur_distance < best_distance) {
-				best_distance = cur_distance;
-			}
-		}
-		sum += cur_distance;
-	}
-	return sum/items.size();
-}
-
 void zip_points2(Curve *grid_curve, Item **item, int pad_length, double max_coord) {
-	vector<Type> *coordinates = new vector<Type>;
-	for(Point *point : grid_curve->get_points() ) {
-		coordinates->push_back(point->get_x());
-		coordinates->push_back(point->get_y());
-	}
-
 	//padding
 	for (size_t i = 0; i < pad_length; i++) {
-		Point *point = new Point(max_coord, max_coord);
-		grid_curve->insert_point(point);
-		coordinates->push_back(point->get_x());
-		coordinates->push_back(point->get_y());
+		grid_curve->insert_point(max_coord, max_coord);
 	}
+	const Type *xy = grid_curve->get_xy();
+	vector<Type> *coordinates = new vector<Type>(xy, xy + 2*grid_curve->get_length());
 
 	*item = new Item(coordinates);
 }
-
-int calculate_curve_w(list<Curve*> curves) {
-	double cur_distance;
-	double best_distance = numeric_limits<double>::max();
-
-	double sum = 0;
-	for(Curve *curve1 : curves) {
-
-		for(Curve *curve2 : curves) {
-			cur_distance = DTW(curve1->get_points(), curve2->get_points());
-			if (cur_distance < best_distance) {
-				best_distance = cur_distance;
-			}
-		}
-		sum += cur_distance;
-	}
-	return sum/curves.size();
-}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "hypercube.hpp"
 
 
@@ -6,12 +8,14 @@ using namespace std;
 typedef double Type;
 
 
-Hash_Table::Hash_Table(int table_size, int dimension, int w, int k){
+Hash_Table_Cube::Hash_Table_Cube(int table_size, int dimension, int w, int k, unsigned long M, unsigned m){
 	this->table_size=table_size;
+	this->dimension=dimension;
+	this->frozen=false;
 	for (int i = 0; i < table_size; i++) {
-		unordered_map<unsigned,int> *it=new unordered_map<unsigned,int>;
-		g_value.push_back(it);
+		f_seeds.push_back(random_f_seed());
 	}
+	flipped.resize(table_size);
 
 	for (size_t y = 0; y < table_size; y++) {
 		vector < vector <float>* > *it1 =new vector < vector <float>* >;
@@ -22,35 +26,175 @@ Hash_Table::Hash_Table(int table_size, int dimension, int w, int k){
 		}
 		s_array.push_back(it1);
 	}
-}
 
-Hash_Table::~Hash_Table() {
+	hash_engine = new Hash_Engine(table_size, dimension, w, k, M, m);
 	for (int i = 0; i < table_size; i++) {
-		delete g_value[i];
+		hash_engine->set_s_array(i, *s_array[i]);
 	}
+}
 
+Hash_Table_Cube::~Hash_Table_Cube() {
 	for (vector < vector <float>* >* vv: s_array) {
 		for (vector <float>* v : *vv) {
 			delete v;
 		}
 		delete vv;
 	}
+	delete hash_engine;
+
+}
+
+
+template <typename T> void Hash_Table_Cube::insert(uint32_t id, const T *x) {
+	f_value.insert(pair<unsigned, uint32_t>(p(x),id) );
+}
+
+//bit of the g value on dimension i: the seeded one, unless balance() flipped it
+unsigned Hash_Table_Cube::f(int i, unsigned g) const {
+	unsigned bit = f_hash_function(g, f_seeds[i]);
+	if (flipped[i].empty() == false && binary_search(flipped[i].begin(), flipped[i].end(), g)) {
+		bit ^= 1;
+	}
+	return bit;
+}
+
+//picks the bits of the g values of the items before they are inserted, one dimension after
+//the other. The g values are taken from the most items to the fewest, and each one gets the
+//bit that adds the fewest items to the vertices (so far) its items would share, which keeps
+//the sum of the squared vertex loads low. A g value of no item keeps its seeded bit.
+template <typename T> void Hash_Table_Cube::balance(const Dataset<T> *dataset) {
+	uint32_t size = dataset->get_size();
+	vector<unsigned> g_values((size_t)size*table_size);
+	for (uint32_t id = 0; id < size; id++) {
+		hash_engine->g_hash(dataset->get_coordinates(id), &g_values[(size_t)id*table_size]);
+	}
+
+	vector<unsigned> vertices(size, 0); //the bits of the dimensions done
+	vector<pair<unsigned, uint32_t>> items(size);
+	vector<pair<uint32_t, uint32_t>> groups; //(items, first) of every g value
+	unordered_map<unsigned, uint32_t> loads;
+	for (int i = 0; i < table_size; i++) {
+		for (uint32_t id = 0; id < size; id++) {
+			items[id] = make_pair(g_values[(size_t)id*table_size + i], id);
+		}
+		sort(items.begin(), items.end());
+		groups.clear();
+		for (uint32_t j = 0; j < size; j++) {
+			if (j == 0 || items[j].first != items[j - 1].first) {
+				groups.push_back(make_pair(0, j));
+			}
+			groups.back().first++;
+		}
+		sort(groups.begin(), groups.end(), [](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {
+			return a.first > b.first;
+		});
+
+		flipped[i].clear();
+		loads.clear();
+		loads.reserve(2*groups.size());
+		for (const pair<uint32_t, uint32_t>& group : groups) {
+			unsigned g = items[group.second].first;
+			uint64_t cost[2] = {0, 0};
+			for (uint32_t j = group.second; j < group.second + group.first; j++) {
+				unsigned vertex = vertices[items[j].second] << 1;
+				auto it = loads.find(vertex);
+				cost[0] += it == loads.end() ? 0 : it->second;
+				it = loads.find(vertex | 1);
+				cost[1] += it == loads.end() ? 0 : it->second;
+			}
+			unsigned seeded = f_hash_function(g, f_seeds[i]);
+			unsigned bit = cost[0] == cost[1] ? seeded : cost[1] < cost[0];
+			if (bit != seeded) {
+				flipped[i].push_back(g);
+			}
+			for (uint32_t j = group.second; j < group.second + group.first; j++) {
+				unsigned& vertex = vertices[items[j].second];
+				vertex = vertex << 1 | bit;
+				loads[vertex]++;
+			}
+		}
+		sort(flipped[i].begin(), flipped[i].end());
+	}
+}
 
+//moves the vertices out of the map into the arrays, after the bulk insert. A cube of
+//up to 2^BUCKET_ARRAY_MAX_KEY_BITS vertices gets an offset for each of them, so a probe is
+//an index into the offsets instead of a search
+void Hash_Table_Cube::freeze() {
+	vector<pair<unsigned, uint32_t>> entries(f_value.begin(), f_value.end());
+	unordered_multimap<unsigned, uint32_t>().swap(f_value);
+	if (table_size <= BUCKET_ARRAY_MAX_KEY_BITS) {
+		buckets.build_dense(entries, table_size);
+	}
+	else {
+		buckets.build(entries);
+	}
+	frozen = true;
 }
 
+bool Hash_Table_Cube::get_bucket(unsigned vertex, const uint32_t **begin, const uint32_t **end) const {
+	return buckets.get_bucket(vertex, begin, end);
+}
 
-void Hash_Table::insert(Item*item,int dimension, int w, int k,int bits_of_each_hash, unsigned M,vector<unsigned> m_powers) {
-	unsigned index =p(*item->get_coordinates(),dimension,table_size,w,k,bits_of_each_hash,M,m_powers);
-	f_value.insert(pair<unsigned, Item*>(index,item) );
+void Hash_Table_Cube::print_loads() {
+	buckets.print_loads();
+}
 
+//the shifts of the g functions, the keys and the flipped g values of the f functions and the vertices
+void Hash_Table_Cube::save(Index_Writer& writer) {
+	for (int i = 0; i < table_size; i++) {
+		for (vector<float> *s : *s_array[i]) {
+			writer.write(s->data(), dimension*sizeof(float));
+		}
+	}
+	writer.write(f_seeds.data(), table_size*sizeof(uint64_t));
+	for (int i = 0; i < table_size; i++) {
+		writer.write_value<uint32_t>(flipped[i].size());
+		writer.write(flipped[i].data(), flipped[i].size()*sizeof(unsigned));
+	}
+	buckets.save(writer);
+}
+
+bool Hash_Table_Cube::load(Index_Reader& reader, uint32_t num_of_items) {
+	for (int i = 0; i < table_size; i++) {
+		for (vector<float> *s : *s_array[i]) {
+			const float *values = reader.read_array<float>(dimension);
+			if (values == NULL) {
+				return false;
+			}
+			s->assign(values, values + dimension);
+		}
+		hash_engine->set_s_array(i, *s_array[i]);
+	}
+	const uint64_t *seeds = reader.read_array<uint64_t>(table_size);
+	if (seeds == NULL) {
+		return false;
+	}
+	f_seeds.assign(seeds, seeds + table_size);
+	for (int i = 0; i < table_size; i++) {
+		uint32_t size;
+		if (reader.read_value(size) == false) {
+			return false;
+		}
+		const unsigned *g_values = reader.read_array<unsigned>(size);
+		if (g_values == NULL) {
+			return false;
+		}
+		flipped[i].assign(g_values, g_values + size);
+	}
+	unordered_multimap<unsigned, uint32_t>().swap(f_value);
+	frozen = buckets.load(reader, num_of_items);
+	return frozen;
 }
 
-unsigned Hash_Table::p(vector<Type> x , int dimension, int table_size, int w, int k,
-	int bits_of_each_hash, unsigned M, vector<unsigned>& m_powers){
+//vertex of a query, the f functions keep no state so many queries can hash at once
+template <typename T> unsigned Hash_Table_Cube::p(const T *x) const {
+	unsigned g_values[table_size];
 	int result=0;
 	int p;
+	hash_engine->g_hash(x, g_values);
 	for (int i = 0; i < table_size; i++) {
-		p = f_hash_function(x,dimension,w,k,bits_of_each_hash,M,m_powers,*s_array[i],g_value,i);
+		p = f(i,g_values[i]);
 		result |= p << (table_size -i -1);
 	}
 	return result;
@@ -58,168 +202,243 @@ unsigned Hash_Table::p(vector<Type> x , int dimension, int table_size, int w, in
 
 
 
-void Hypercube::insert_item(Item *item){
-		hash_table->insert(item,this->dimension,this->w,this->k,-this->bits_of_each_hash,this->M,this->m_powers);
+template <typename T> void Hypercube<T>::insert_item(uint32_t id){
+	for (int i = 0; i < L; i++) {
+		hash_tables[i]->insert(id,dataset->get_coordinates(id));
+	}
 }
 
-Hypercube::Hypercube(int hash_table_size, int dimension, int w, int k,unsigned m,unsigned M){
+template <typename T>
+Hypercube<T>::Hypercube(int L, int hash_table_size, Dataset<T> *dataset, int w, int k,unsigned m,unsigned M){
+	int dimension = dataset->get_dimension();
+	this->dataset=dataset;
+	this->index_file=NULL;
 	this->dimension=dimension;
 	this->w=w;
 	this->k=k;
 	this->bits_of_each_hash=32/k;
 	this->m=m;
 	this->table_size=hash_table_size;
+	this->L=L;
 	this->M_f=M;
-	this->hash_table = new Hash_Table(hash_table_size, dimension, w, k);
 	if (k == 1) {
-		this->M = numeric_limits<unsigned>::max();
+		this->M = (unsigned long)numeric_limits<unsigned>::max() + 1;
 	}
 	else {
 		this->M = pow(2, bits_of_each_hash);
 	}
-	for (int i = 0; i < dimension; i++) {
-		m_powers.push_back( pow_mod(m, i, M) );
+	for (int i = 0; i < L; i++) {
+		hash_tables.push_back(new Hash_Table_Cube(hash_table_size, dimension, w, k, this->M, m));
 	}
 
 }
 
-void Hypercube::ANN(Item *query, unsigned probes, Query_Result& query_result){
-	int searched_items;
-	unsigned best_distance = numeric_limits<unsigned>::max();
-	unsigned  F_value;
-	string best = "";
-	unordered_multimap<unsigned, Item*> *map;
-	pair <unordered_multimap<unsigned, Item*>::iterator, unordered_multimap<unsigned,Item*>::iterator> ret;
-	unordered_multimap<unsigned, Item*>::iterator it;
+template <typename T> Hypercube<T>::~Hypercube(){
+	for (int i = 0; i < L; i++) {
+		delete hash_tables[i];
+	}
+	delete index_file;
+}
 
-	int bucketes_checked=0;
-	time_t time;
-	time = clock();
-	F_value = hash_table->p(*(query->get_coordinates()),dimension,
-	                        table_size, w, k, bits_of_each_hash, M,  m_powers);
+//balanced vertices for the items of the dataset, called before they are inserted
+template <typename T> void Hypercube<T>::balance(){
+	for (int i = 0; i < L; i++) {
+		hash_tables[i]->balance(dataset);
+	}
+}
 
-	map = hash_table->get_f_values_map();
-	ret = map->equal_range(F_value);
-	searched_items = 0;
+template <typename T> void Hypercube<T>::freeze(){
+	for (int i = 0; i < L; i++) {
+		hash_tables[i]->freeze();
+	}
+}
 
-	unsigned bucket_value;
+template <typename T> void Hypercube<T>::print_vertex_loads(){
+	if (is_frozen() == false) {
+		freeze();
+	}
+	for (int i = 0; i < L; i++) {
+		cout <<"cube "<<i<<" of 2^"<<table_size<<" vertices: ";
+		hash_tables[i]->print_loads();
+	}
+}
 
-		for (it = ret.first; it != ret.second; ++it) {
-			if (searched_items >= M_f) {
-				break;
-			}
-			unsigned cur_distance = Hypercube_distance(query, it->second);//apostasi querry apo ta alla pou iparxoun sto bucket
-			if (cur_distance < best_distance) {
-				best = it->second->get_name();
-				best_distance = cur_distance;
-			}
-			searched_items++;
+template <typename T> bool Hypercube<T>::is_frozen() const {
+	return hash_tables[0]->is_frozen();
+}
+
+//writes the index to a binary file that load() maps back in place
+template <typename T> bool Hypercube<T>::save(const string& file_name, uint64_t dataset_hash){
+	Index_Writer writer;
+	if (is_frozen() == false) {
+		freeze();
+	}
+	if (writer.open(file_name, INDEX_FILE_HYPERCUBE) == false) {
+		return false;
+	}
+	writer.write_value<int32_t>(L);
+	writer.write_value<int32_t>(table_size);
+	writer.write_value<int32_t>(k);
+	writer.write_value<int32_t>(w);
+	writer.write_value<int32_t>(dimension);
+	writer.write_value<uint64_t>(M);
+	writer.write_value<uint32_t>(m);
+	writer.write_value<uint32_t>(dataset->get_size());
+	writer.write_value<uint32_t>(Element_Type<T>::code);
+	writer.write_value<uint64_t>(dataset_hash);
+	for (int i = 0; i < L; i++) {
+		hash_tables[i]->save(writer);
+	}
+	return writer.close();
+}
+
+//opens an index written by save() for the same dataset file and element type, M is the search
+//budget of the queries. The vertices stay in the mapped file. NULL when the file does not fit
+template <typename T>
+Hypercube<T>* Hypercube<T>::load(const string& file_name, Dataset<T> *dataset, uint64_t dataset_hash, unsigned M){
+	Index_Reader *reader = new Index_Reader();
+	int32_t L, table_size, k, w, dimension;
+	uint64_t hash_M, file_dataset_hash;
+	uint32_t m, size, element_type;
+
+	if (reader->open(file_name, INDEX_FILE_HYPERCUBE) == false
+			|| reader->read_value(L) == false || L < 1 || reader->read_value(table_size) == false || reader->read_value(k) == false
+			|| k < 1 || k > 32 || table_size < 1 || table_size > 32
+			|| reader->read_value(w) == false || reader->read_value(dimension) == false
+			|| reader->read_value(hash_M) == false || reader->read_value(m) == false
+			|| reader->read_value(size) == false || reader->read_value(element_type) == false
+			|| reader->read_value(file_dataset_hash) == false
+			|| dimension != dataset->get_dimension() || size != dataset->get_size()
+			|| element_type != Element_Type<T>::code || file_dataset_hash != dataset_hash) {
+		delete reader;
+		return NULL;
+	}
+
+	Hypercube *hypercube = new Hypercube(L, table_size, dataset, w, k, m, M);
+	hypercube->index_file = reader;
+	if (hypercube->M != hash_M) {
+		delete hypercube;
+		return NULL;
+	}
+	for (int i = 0; i < L; i++) {
+		if (hypercube->hash_tables[i]->load(*reader, size) == false) {
+			delete hypercube;
+			return NULL;
 		}
-		unsigned nbuckets=hash_table->get_f_values_map()->bucket_count();
-		for (unsigned i=0; i<nbuckets; i++) {
-			if (searched_items >= M_f || bucketes_checked >probes) {
-				break;
-			}
+	}
+	return hypercube;
+}
 
-	  	  	for (auto it = hash_table->get_f_values_map()->begin(i);it!= hash_table->get_f_values_map()->end(i);it++){
-				bucket_value=hash_table->get_f_values_map()->begin(i)->first;
-				break;
-	    	}
-			if (hammingDistance(F_value, bucket_value)==1){
-				bucketes_checked++;
-				ret = map->equal_range(bucket_value);
-				for (it = ret.first; it != ret.second; ++it) {
-					if (searched_items >= M_f) {
-						break;
-					}
-					unsigned cur_distance = Hypercube_distance(query, it->second);//apostasi querry apo ta alla pou iparxoun sto bucket
-					if (cur_distance < best_distance) {
-						best = it->second->get_name();
-						best_distance = cur_distance;
-					}
-					searched_items++;
+//the capacity of neighbours nearest items in the vertices of the query and in up to probes
+//other vertices of every cube, in increasing hamming distance from them, until M items are
+//searched. All the cubes flip the same bits at each step, so they are probed in turns.
+template <typename T> bool Hypercube<T>::kANN(const T *query, unsigned probes, KNN_Heap& neighbours) const {
+	int searched_items = 0;
+	unsigned probed = 0;
+	unsigned vertices[L];
+	unsigned flips = 0;
+	const uint32_t *begin, *end, *it;
+
+	if (is_frozen() == false) {
+		return false;
+	}
+
+	Visited_Set& visited_set = get_visited_set();
+	visited_set.start(dataset->get_size());
+	for (int i = 0; i < L; i++) {
+		vertices[i] = hash_tables[i]->p(query);
+	}
+	Hamming_Ball hamming_ball(0, table_size);
+	do {
+		for (int i = 0; i < L && searched_items < M_f; i++) {
+			if (hash_tables[i]->get_bucket(vertices[i] ^ flips, &begin, &end) == false) {
+				continue;
+			}
+			for (it = begin; it != end && searched_items < M_f; ++it) {
+				if (visited_set.visit(*it) == false) {
+					continue;
 				}
+				double cur_distance = Hypercube_distance(query, dataset->get_coordinates(*it), neighbours.get_threshold());//apostasi querry apo ta alla pou iparxoun sto bucket
+				neighbours.push(*it, cur_distance);
+				searched_items++;
 			}
-	    }
+		}
+	} while (searched_items < M_f && probed++ < probes && hamming_ball.next(flips));
+	return true;
+}
 
+template <typename T> bool Hypercube<T>::ANN(const T *query, unsigned probes, Query_Result& query_result) const {
+	KNN_Heap neighbours(1);
 
-	time = clock() - time;
+	double time;
+	time = get_wall_time();
+	bool searched = kANN(query, probes, neighbours);
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
 
-	if (best != "") {
-		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(dataset->get_name(neighbours.get_neighbour(0).id));
 	}
 	else {
 		query_result.set_best_distance(-1);
 		query_result.set_time(-1);
 		query_result.set_best_item("NULL");
 	}
+	return searched;
 }
-void Hypercube::range_search(Item *query, unsigned prompt, float radious,
-		list<Item*>& range_items, Query_Result& query_result) {
-		int searched_items;
+template <typename T> bool Hypercube<T>::range_search(const T *query, unsigned prompt, float radious,
+		list<uint32_t>& range_items, Query_Result& query_result) const {
+		int searched_items = 0;
+		unsigned probed = 0;
 		unsigned best_distance = numeric_limits<unsigned>::max();
-		unsigned  F_value;
+		unsigned vertices[L];
+		unsigned flips = 0;
 		string best = "";
-		unordered_multimap<unsigned, Item*> *map;
-		pair <unordered_multimap<unsigned, Item*>::iterator, unordered_multimap<unsigned,Item*>::iterator> ret;
-		unordered_multimap<unsigned, Item*>::iterator it;
+		const uint32_t *begin, *end, *it;
 
-		int bucketes_checked=0;
-		time_t time;
-		time = clock();
-		F_value = hash_table->p(*(query->get_coordinates()),dimension,
-		                        table_size, w, k, bits_of_each_hash, M,  m_powers);
-
-		map = hash_table->get_f_values_map();
-		ret = map->equal_range(F_value);
-		searched_items = 0;
+		if (is_frozen() == false) {
+			return false;
+		}
 
-		unsigned bucket_value;
+		double time;
+		time = get_wall_time();
+		for (int i = 0; i < L; i++) {
+			vertices[i] = hash_tables[i]->p(query);
+		}
 
-			for (it = ret.first; it != ret.second; ++it) {
-				if (searched_items >= M_f) {
-					break;
+		//the vertices of the query, then up to prompt others of every cube in increasing
+		//hamming distance. An item of many cubes is reported once.
+		Visited_Set& visited_set = get_visited_set();
+		visited_set.start(dataset->get_size());
+		Hamming_Ball hamming_ball(0, table_size);
+		do {
+			for (int i = 0; i < L && searched_items < M_f; i++) {
+				if (hash_tables[i]->get_bucket(vertices[i] ^ flips, &begin, &end) == false) {
+					continue;
 				}
-				unsigned cur_distance = Hypercube_distance(query, it->second);//apostasi querry apo ta alla pou iparxoun sto bucket
-				if (cur_distance < radious) {
-					range_items.push_back(it->second);
+				for (it = begin; it != end && searched_items < M_f; ++it) {
+					if (visited_set.visit(*it) == false) {
+						continue;
+					}
+					double cur_distance = Hypercube_distance(query, dataset->get_coordinates(*it), radious);//apostasi querry apo ta alla pou iparxoun sto bucket
+					if (cur_distance < radious) {
+						range_items.push_back(*it);
+					}
+					searched_items++;
 				}
-				searched_items++;
 			}
-			unsigned nbuckets=hash_table->get_f_values_map()->bucket_count();
-			for (unsigned i=0; i<nbuckets; i++) {
-				if (searched_items >= M_f || bucketes_checked>=prompt) {
-					break;
-				}
+		} while (searched_items < M_f && probed++ < prompt && hamming_ball.next(flips));
 
-		  	  	for (auto it = hash_table->get_f_values_map()->begin(i);it!= hash_table->get_f_values_map()->end(i);it++){
-					bucket_value=hash_table->get_f_values_map()->begin(i)->first;
-					break;
-		    	}
-				if (hammingDistance(F_value, bucket_value)==1){
-					bucketes_checked++;
-					ret = map->equal_range(bucket_value);
-					for (it = ret.first; it != ret.second; ++it) {
-						if (searched_items >= M_f) {
-							break;
-						}
-						unsigned cur_distance = Hypercube_distance(query, it->second);//apostasi querry apo ta alla pou iparxoun sto bucket
-						if (cur_distance < radious) {
-							range_items.push_back(it->second);
-						}
-						searched_items++;
-					}
-				}
-		    }
+		time = get_wall_time() - time;
 
 
-		time = clock() - time;
+		query_result.set_latency(time);
 
 		if (best != "") {
 			query_result.set_best_distance(best_distance);
-			query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
+			query_result.set_time(time);
 			query_result.set_best_item(best);
 		}
 		else {
@@ -227,8 +446,19 @@ void Hypercube::range_search(Item *query, unsigned prompt, float radious,
 			query_result.set_time(-1);
 			query_result.set_best_item("NULL");
 		}
+		return true;
 }
 
-unsigned long long int Hypercube::Hypercube_distance(Item *item1, Item *item2) {
-	return manhattan_distance(*(item1->get_coordinates()), *(item2->get_coordinates()));
+template <typename T> double Hypercube<T>::Hypercube_distance(const T *x1, const T *x2, double threshold) const {
+	return manhattan_distance(x1, x2, dimension, threshold);
 }
+
+#define INSTANTIATE_HYPERCUBE(T) \
+	template void Hash_Table_Cube::insert(uint32_t id, const T *x); \
+	template unsigned Hash_Table_Cube::p(const T *x) const; \
+	template void Hash_Table_Cube::balance(const Dataset<T> *dataset); \
+	template class Hypercube<T>;
+INSTANTIATE_HYPERCUBE(double)
+INSTANTIATE_HYPERCUBE(float)
+INSTANTIATE_HYPERCUBE(int16_t)
+INSTANTIATE_HYPERCUBE(uint8_t)
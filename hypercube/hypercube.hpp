@@ -7,31 +7,50 @@
 #include <iostream>
 #include "../query_result/query_result.hpp"
 #include "../item/item.hpp"
+#include "../dataset/dataset.hpp"
 #include "../helping_functions/helping_functions.hpp"
+#include "../hash_engine/hash_engine.hpp"
+#include "../bucket_array/bucket_array.hpp"
+#include "../index_file/index_file.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../visited_set/visited_set.hpp"
+#include "../hamming_ball/hamming_ball.hpp"
 
 using namespace std;
 
 typedef double Type;
 
 
-class Hash_Table {
+class Hash_Table_Cube {
 public:
-	Hash_Table(int table_size, int dimension, int w, int k);
-	~Hash_Table();
-	void insert(Item*item, int dimension, int w, int k, int bits_of_each_has, unsigned M,vector<unsigned> m_powers);
-	Item* find(Item *item, int dimension, int w, int k, int bits_of_each_has, unsigned M);
-	unsigned p(vector<Type> x , int dimension, int table_size, int w, int k,
-		int bits_of_each_hash, unsigned M, vector<unsigned>& m_powers);
+	Hash_Table_Cube(int table_size, int dimension, int w, int k, unsigned long M, unsigned m);
+	~Hash_Table_Cube();
+	template <typename T> void insert(uint32_t id, const T *x);
+	template <typename T> unsigned p(const T *x) const;
+	template <typename T> void balance(const Dataset<T> *dataset);
+	void freeze();
+	bool get_bucket(unsigned vertex, const uint32_t **begin, const uint32_t **end) const;
+	void save(Index_Writer& writer);
+	bool load(Index_Reader& reader, uint32_t num_of_items);
 	void print();
-	int get_table_size() {return table_size;}
+	void print_loads();
+	int get_table_size() const {return table_size;}
+	bool is_frozen() const {return frozen;}
 	//vector<vector<float>*>& get_s_array(){return s_array;};
-	unordered_multimap<unsigned, Item*>* get_f_values_map(){return &f_value;};
+	unordered_multimap<unsigned, uint32_t>* get_f_values_map(){return &f_value;};
 
 private:
-	unordered_multimap <unsigned,Item*> f_value;
-	vector< unordered_map<unsigned,int> *> g_value;
+	unsigned f(int i, unsigned g) const;
+
+	unordered_multimap <unsigned,uint32_t> f_value; //vertex -> item id, until frozen
+	Bucket_Array buckets; //frozen form of f_value
+	bool frozen;
+	vector<uint64_t> f_seeds; //key of the f function of every cube dimension
+	vector<vector<unsigned>> flipped; //sorted g values of every dimension whose bit balance() flipped
 	vector<vector < vector <float>* >* > s_array;
+	Hash_Engine *hash_engine;//all the g of the f bits in one pass
 	int table_size;//k comnd line
+	int dimension;
 
 };
 
@@ -39,21 +58,40 @@ private:
 
 
 
-class Hypercube{
+//the index of a Dataset<T>, instantiated for double, float, int16_t and uint8_t. It has L
+//independently seeded cubes, a query probes all of them under one budget of M items
+template <typename T> class Hypercube{
 public:
-  	Hypercube(int hash_table_size, int dimension, int w, int k,unsigned m,unsigned M);
-	void insert_item(Item *item);
-	int get_w() {return w;}
-	int get_k() {return k;}
-	int get_dimension() {return dimension;}
-	unsigned long long Hypercube_distance(Item *item1, Item *item2);
-	void range_search(Item *query, unsigned threshhold, float radious,
-		list<Item*>& range_items, Query_Result& query_result);
+  	Hypercube(int L, int hash_table_size, Dataset<T> *dataset, int w, int k,unsigned m,unsigned M);
+	~Hypercube();
+	//the inserted items are searched only after freeze()
+	void insert_item(uint32_t id);
+	void balance();
+	void freeze();
+	//dataset_hash is hash_file() of the file of the dataset, load() fails when it differs
+	bool save(const string& file_name, uint64_t dataset_hash);
+	static Hypercube* load(const string& file_name, Dataset<T> *dataset, uint64_t dataset_hash, unsigned M);
+	int get_L() const {return L;}
+	int get_w() const {return w;}
+	int get_k() const {return k;}
+	int get_dimension() const {return dimension;}
+	bool is_frozen() const;
+	double Hypercube_distance(const T *x1, const T *x2, double threshold) const;
+	//the queries only read the cubes, so many threads can run them at once. They
+	//return false and search nothing while the cubes are not frozen
+	bool range_search(const T *query, unsigned threshhold, float radious,
+		list<uint32_t>& range_items, Query_Result& query_result) const;
 	void print_hash_tables();
-	void ANN(Item *query, unsigned threshhold, Query_Result& query_result);
-	Hash_Table* hash_table;
+	void print_vertex_loads();
+	bool kANN(const T *query, unsigned probes, KNN_Heap& neighbours) const;
+	bool ANN(const T *query, unsigned threshhold, Query_Result& query_result) const;
 private:
+
+	vector<Hash_Table_Cube*> hash_tables;
+	Dataset<T> *dataset;
+	Index_Reader *index_file; //mapped file of a loaded index, owns its buckets
 	int table_size;//k comand line
+	int L;
   	int w;
   	int k;//for g,h
   	int dimension;
@@ -61,6 +99,5 @@ private:
   	unsigned long M;// for g,h
 	unsigned m;
   	unsigned bits_of_each_hash;
-	vector<unsigned> m_powers;
 };
 #endif
@@ -16,102 +16,184 @@ typedef double Type;
 #include "../helping_functions/helping_functions.hpp"
 #include "../query_result/query_result.hpp"
 #include "../item/item.hpp"
+#include "../dataset/dataset.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../exact_search/exact_search.hpp"
+#include "../ground_truth/ground_truth.hpp"
+#include "../latency_histogram/latency_histogram.hpp"
 #define M_DEFAULT 5000
 #define K_DEFAULT 4
 #define W_DEFAULT 4000
 #define PROBES_DEFAULT 14
+#define L_DEFAULT 1
+#define THREADS_DEFAULT 1
 
 
-int main(int argc, char *argv[]) {
+//the whole program for vectors of T
+template <typename T> static int run(int argc, char *argv[]) {
 		int k;
 		int k_s_g = K_DEFAULT;
 		int w = W_DEFAULT;
 		int M = M_DEFAULT;
 		int probes = PROBES_DEFAULT;
+		int L = L_DEFAULT;
+		int threads = THREADS_DEFAULT;
 		float radious = -1;
+		bool exact = false;
+		bool balanced = false;
 		int PRINT_ON_SCREAN=0;
 
 	    //READ COMMAND LINE ARGUMENTS
 	  string input_file, query_file, output_file;
+	  string save_index_file, load_index_file;
+	  string ground_truth_file;
 		int flag_defult=-1;
-		read_command_line_arguments_hypercube(argv, argc, input_file, query_file,output_file,k,M,probes,flag_defult);
+		read_command_line_arguments_hypercube(argv, argc, input_file, query_file,output_file,k,M,probes,L,flag_defult,
+			save_index_file,load_index_file,threads,exact,balanced,ground_truth_file);
 
 		if(output_file==""){
 				PRINT_ON_SCREAN=1;
 		}
+		if (L < 1) {
+			cout <<"L must be at least 1"<<endl;
+			return 1;
+		}
 	    //READ ITEMS FROM THE INPUT FILE
-	  list<Item*> input_items;
+	  Dataset<T> input_items;
 	  read_vectors_from_file(input_file, input_items);
+		if (input_items.get_size() == 0) {
+			cout <<"No vectors in the input file: "<<input_file<<endl;
+			return 1;
+		}
 		int table_size=k;//initilized after insert items
 
-	  int dimension = input_items.front()->get_coordinates()->size();
 		if (flag_defult==-1){
-			table_size=log2(input_items.size());
+			table_size=log2(input_items.get_size());
 		}
     unsigned m = numeric_limits<unsigned>::max() + 1 - 5;
 		cout << "k " << k_s_g<<endl;
 		cout << "M " << M<<endl;
 		cout << "probes " << probes << endl;
-		//CREATE THE HYPERCUBE STRUCTURE
-
-		Hypercube hypercube (table_size,dimension,w,k_s_g,m,M);
+		cout << "element type " << get_element_type_name(Element_Type<T>::code) << endl;
+		cout << "distance kernel " << get_distance_kernel_name<T>() << endl;
+		cout << "search " << (exact ? "exact" : "cube") << endl;
+		Hypercube<T> *hypercube;
+		double time = get_wall_time();
+		if (load_index_file != "") {
+			//LOAD THE HYPERCUBE STRUCTURE, ITS PARAMETERS COME FROM THE FILE
+			hypercube = Hypercube<T>::load(load_index_file, &input_items, hash_file(input_file), M);
+			if (hypercube == NULL) {
+				cout <<"Index loading error: "<<load_index_file<<endl;
+				return 1;
+			}
+			time = get_wall_time() - time;
+			cout <<"Index loading total time: "<< time <<endl<<endl;
+		}
+		else {
+			//CREATE THE HYPERCUBE STRUCTURE
+			hypercube = new Hypercube<T>(L,table_size,&input_items,w,k_s_g,m,M);
+			if (balanced) {
+				//BALANCE THE VERTICES OVER THE INPUT DATA
+				hypercube->balance();
+			}
 
+			//INSERT INPUT DATA
+			for (uint32_t id = 0; id < input_items.get_size(); id++) {
+				hypercube->insert_item(id);
+			}
+			hypercube->freeze();
 
-		//INSERT INPUT DATA
-		time_t time = clock();
-		for(Item *item: input_items) {
-			hypercube.insert_item(item);
+			time = get_wall_time() - time;
+			cout <<"Data insertion total time: "<< time <<endl<<endl;
+		}
+		cout << "L " << hypercube->get_L() << endl;
+		hypercube->print_vertex_loads();
+		if (save_index_file != "" && hypercube->save(save_index_file, hash_file(input_file)) == false) {
+			cout <<"Index saving error: "<<save_index_file<<endl;
+			return 1;
 		}
-
-		time = clock() - time;
-		cout <<"Data insertion total time: "<< ((double)time) / CLOCKS_PER_SEC <<endl<<endl;
 
 		//HANDLE QUERIES
-		list<Item*> queries;
+		Dataset<T> queries;
 		read_vectors_from_file(query_file, queries, radious);
 		if (radious != -1) {
 			cout <<"Radious: "<<radious<<endl;
 		}
 
-		Query_Result ann_query_result, exhaustive_query_result,range_query_result;
-		time = clock();
+		//answer the queries in parallel, every query has its own results
+		uint32_t num_of_queries = queries.get_size();
+		vector<Query_Result> ann_query_results(num_of_queries);
+		vector<Query_Result> exhaustive_query_results(num_of_queries);
+		vector<Query_Result> range_query_results(num_of_queries);
+		vector<list<uint32_t>> range_items(num_of_queries);
+		double wall_time = get_wall_time();
+
+		//Exact nearest neighbours of all the queries, from the ground truth file when it has
+		//them or in tiles on every core. Text files read as another element type are rounded,
+		//so their ground truth is kept apart.
+		vector<KNN_Heap> exact_neighbours(num_of_queries, KNN_Heap(1));
+		vector<double> exact_times(num_of_queries);
+		double exact_time = get_wall_time();
+		Thread_Pool exact_thread_pool(max(1u, thread::hardware_concurrency()));
+		uint64_t variant = Element_Type<T>::code == DATASET_FILE_DOUBLE ? 0 : Element_Type<T>::code;
+		get_ground_truth(ground_truth_file, input_file, query_file, variant, input_items.get_size(), exact_neighbours, exact_times, [&] {
+			exact_search(&input_items, &queries, exact_neighbours, exact_times, exact_thread_pool);
+		});
+		for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+			ground_truth_result(exact_neighbours[query_id], exact_times[query_id], &input_items,
+				exhaustive_query_results[query_id]);
+		}
+		exact_time = get_wall_time() - exact_time;
+
+		Latency_Histogram hit_latencies, empty_latencies;
+		Thread_Pool thread_pool(threads);
+		thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+			const T *query = queries.get_coordinates(query_id);
+
+			//approximate nearest neighbor, the exact one in the exact mode
+			if (exact) {
+				ann_query_results[query_id] = exhaustive_query_results[query_id];
+			}
+			else {
+				hypercube->ANN(query, probes, ann_query_results[query_id]);
+				record_latency(ann_query_results[query_id], hit_latencies, empty_latencies);
+			}
+
+			//range search (Bonus)
+			if (radious > 0) {
+				hypercube->range_search(query, 1000000, radious, range_items[query_id],
+					range_query_results[query_id]);
+			}
+		});
+		wall_time = get_wall_time() - wall_time;
+
+		//print the results and the statistics in query order
 		double sum_query_time = 0;
 		double max_rate = -1;
 		double sum_rate = 0;
 		int found_nearest = 0;
 		int total_distances = 0;
 		int not_null = 0;
-		list<Item*> range_items;
 		FILE *out;
 		out= fopen(output_file.c_str(), "w");
-		for(Item *query: queries) {
-			//approximate nearest neighbor
-			hypercube.ANN(query, probes, ann_query_result);
-			//print_ann_results(ann_query_result);
-
-			//Exact nearest neighbor
-			exhaustive_search(&input_items, query, exhaustive_query_result);
-			//print_exhaustive_search_results(exhaustive_query_result);
+		for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+			Query_Result& ann_query_result = ann_query_results[query_id];
+			Query_Result& exhaustive_query_result = exhaustive_query_results[query_id];
+
 			if(PRINT_ON_SCREAN==1)
-				print_results(query->get_name(),ann_query_result,"Cube", exhaustive_query_result);
+				print_results(queries.get_name(query_id),ann_query_result,"Cube", exhaustive_query_result);
 			else
-				print_results_to_file(query->get_name(),ann_query_result,"Cube",out ,exhaustive_query_result);
+				print_results_to_file(queries.get_name(query_id),ann_query_result,"Cube",out ,exhaustive_query_result);
 
-			//range search (Bonus)
 			if (radious > 0) {
-				hypercube.range_search(query, 1000000, radious, range_items, range_query_result);
-
 				if(PRINT_ON_SCREAN ==1) {
-					print_range_results(range_items, radious);
+					print_range_results(range_items[query_id], &input_items, radious);
 				}
 				else {
-					print_range_results_to_file(range_items, out,radious);
+					print_range_results_to_file(range_items[query_id], &input_items, out, radious);
 				}
-				range_items.clear();
 			}
 
-
-			//cout <<"--------------------------------------------------------"<<endl;
 			//statistics info
 			if (ann_query_result.get_time() != -1) {
 					sum_query_time += ann_query_result.get_time();
@@ -123,22 +205,35 @@ int main(int argc, char *argv[]) {
 					total_distances += ann_query_result.get_best_distance();
 					not_null++;
 			}
-			//cout <<"\nEND \n";
 
 		}
 
-		time = clock() - time;
-		cout <<"Handling of queries(ann and enn) total time: "<< ((double)time) / CLOCKS_PER_SEC<<endl;
+		cout <<"Handling of queries(ann and enn) total time: "<< wall_time
+			<<" ("<<thread_pool.get_num_of_threads()<<" threads)"<<endl;
+		cout <<"Exact search total time: "<< exact_time
+			<<" ("<<exact_thread_pool.get_num_of_threads()<<" threads)"<<endl;
 		cout << "Average query time: "<<sum_query_time/not_null<<endl;
 		cout << "Max AF: "<<max_rate<<endl;
 		cout << "Average AF: "<<sum_rate/not_null<<endl;
-		cout << "Found "<<not_null<<"/"<<queries.size()<<" approximate nearest neighbors"<<endl;
-		cout << "Found "<<found_nearest<<"/"<<queries.size()<<" exact nearest neighbors"<<endl;
-		cout << "Average distance: "<<total_distances/queries.size()<<endl;
+		cout << "Found "<<not_null<<"/"<<queries.get_size()<<" approximate nearest neighbors"<<endl;
+		cout << "Found "<<found_nearest<<"/"<<queries.get_size()<<" exact nearest neighbors"<<endl;
+		cout << "Average distance: "<<total_distances/queries.get_size()<<endl;
+		print_latencies(hit_latencies, empty_latencies);
 		cout <<"--------------------------------------------------------------------------"<<endl;
 		cout <<endl;
 
-		delete_items(input_items);
-		delete_items(queries);
+		delete hypercube;
 		return 0;
 }
+
+int main(int argc, char *argv[]) {
+		//THE ELEMENT TYPE OF THE VECTORS, FROM -type OR THE INPUT FILE
+		switch (read_element_type(argv, argc)) {
+			case DATASET_FILE_DOUBLE: return run<double>(argc, argv);
+			case DATASET_FILE_FLOAT: return run<float>(argc, argv);
+			case DATASET_FILE_INT16: return run<int16_t>(argc, argv);
+			case DATASET_FILE_UINT8: return run<uint8_t>(argc, argv);
+		}
+		cout <<"Unknown element type, expected double, float, int16 or uint8"<<endl;
+		return 1;
+}
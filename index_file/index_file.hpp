@@ -0,0 +1,65 @@
+#ifndef INDEX_FILE_H
+#define INDEX_FILE_H
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+using namespace std;
+
+//binary index files. A header (magic, version, kind) is followed by the sections of
+//the index, every one of them starting at an INDEX_FILE_ALIGNMENT boundary, so the
+//arrays of a mapped file can be used in place.
+#define INDEX_FILE_MAGIC 0x58444e49 //"INDX"
+#define INDEX_FILE_VERSION 7
+#define INDEX_FILE_ALIGNMENT 8
+
+#define INDEX_FILE_LSH 1
+#define INDEX_FILE_HYPERCUBE 2
+#define INDEX_FILE_GROUND_TRUTH 3
+
+class Index_Writer {
+public:
+	Index_Writer();
+	~Index_Writer();
+
+	bool open(const string& file_name, uint32_t kind);
+	void write(const void *data, size_t bytes);
+	template <typename T> void write_value(T value) {write(&value, sizeof(T));}
+	bool close();
+private:
+	Index_Writer(const Index_Writer&);
+	Index_Writer& operator=(const Index_Writer&);
+
+	FILE *file;
+	size_t position;
+	bool failed;
+};
+
+//maps the whole file read only, the pointers it returns live as long as the reader
+class Index_Reader {
+public:
+	Index_Reader();
+	~Index_Reader();
+
+	bool open(const string& file_name, uint32_t kind);
+	const void* read(size_t bytes);
+	template <typename T> bool read_value(T& value) {
+		const T *data = (const T*)read(sizeof(T));
+		if (data == NULL) {
+			return false;
+		}
+		value = *data;
+		return true;
+	}
+	template <typename T> const T* read_array(size_t count) {return (const T*)read(count*sizeof(T));}
+private:
+	Index_Reader(const Index_Reader&);
+	Index_Reader& operator=(const Index_Reader&);
+
+	const char *data;
+	size_t size;
+	size_t position;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "index_file.hpp"
+
+Index_Writer::Index_Writer() {
+	this->file = NULL;
+	this->position = 0;
+	this->failed = false;
+}
+
+Index_Writer::~Index_Writer() {
+	if (file != NULL) {
+		fclose(file);
+	}
+}
+
+bool Index_Writer::open(const string& file_name, uint32_t kind) {
+	file = fopen(file_name.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	position = 0;
+	failed = false;
+	write_value<uint32_t>(INDEX_FILE_MAGIC);
+	write_value<uint32_t>(INDEX_FILE_VERSION);
+	write_value<uint32_t>(kind);
+	return failed == false;
+}
+
+//appends bytes and pads them up to the next INDEX_FILE_ALIGNMENT boundary
+void Index_Writer::write(const void *data, size_t bytes) {
+	static const char zeros[INDEX_FILE_ALIGNMENT] = {0};
+	size_t padding = (INDEX_FILE_ALIGNMENT - bytes%INDEX_FILE_ALIGNMENT)%INDEX_FILE_ALIGNMENT;
+
+	if (bytes != 0 && fwrite(data, 1, bytes, file) != bytes) {
+		failed = true;
+	}
+	if (padding != 0 && fwrite(zeros, 1, padding, file) != padding) {
+		failed = true;
+	}
+	position += bytes + padding;
+}
+
+bool Index_Writer::close() {
+	if (fclose(file) != 0) {
+		failed = true;
+	}
+	file = NULL;
+	return failed == false;
+}
+
+Index_Reader::Index_Reader() {
+	this->data = NULL;
+	this->size = 0;
+	this->position = 0;
+}
+
+Index_Reader::~Index_Reader() {
+	if (data != NULL) {
+		munmap((void*)data, size);
+	}
+}
+
+//maps the file and checks that it is an index of the given kind and of this version
+bool Index_Reader::open(const string& file_name, uint32_t kind) {
+	struct stat info;
+	uint32_t magic, version, file_kind;
+
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	if (fstat(fd, &info) == -1 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	data = (const char*)mapping;
+	size = info.st_size;
+	position = 0;
+
+	if (read_value(magic) == false || read_value(version) == false || read_value(file_kind) == false) {
+		return false;
+	}
+	return magic == INDEX_FILE_MAGIC && version == INDEX_FILE_VERSION && file_kind == kind;
+}
+
+//the next section of the file, NULL when the file is shorter than that
+const void* Index_Reader::read(size_t bytes) {
+	size_t padding = (INDEX_FILE_ALIGNMENT - bytes%INDEX_FILE_ALIGNMENT)%INDEX_FILE_ALIGNMENT;
+	if (data == NULL || bytes > size - position || bytes + padding > size - position) {
+		return NULL;
+	}
+	const void *section = data + position;
+	position += bytes + padding;
+	return section;
+}
@@ -0,0 +1,36 @@
+#ifndef KNN_HEAP_H
+#define KNN_HEAP_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+struct Neighbour {
+	uint32_t id;
+	double distance;
+};
+
+//the k nearest neighbours found so far. It is a max heap on the distance with a fixed
+//capacity k, so a closer candidate replaces the farthest one in O(log k) and only ids
+//and distances are stored, names are looked up once the search is over.
+class KNN_Heap {
+public:
+	KNN_Heap(int capacity);
+
+	bool push(uint32_t id, double distance);
+	void sort();
+	void clear() {size = 0;}
+	//a candidate has to be closer than this to get in, useful as an early abandon bound
+	double get_threshold() const;
+	int get_size() const {return size;}
+	int get_capacity() const {return capacity;}
+	//after sort() neighbour 0 is the nearest one
+	const Neighbour& get_neighbour(int i) const {return neighbours[i];}
+private:
+	vector<Neighbour> neighbours;
+	int capacity;
+	int size;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+#include "knn_heap.hpp"
+
+//heap order, the farthest neighbour on top and ties broken by id
+static bool closer(const Neighbour& neighbour1, const Neighbour& neighbour2) {
+	if (neighbour1.distance != neighbour2.distance) {
+		return neighbour1.distance < neighbour2.distance;
+	}
+	return neighbour1.id < neighbour2.id;
+}
+
+KNN_Heap::KNN_Heap(int capacity) {
+	this->capacity = max(capacity, 0);
+	this->size = 0;
+	this->neighbours.resize(this->capacity);
+}
+
+//keeps the candidate if it is among the capacity nearest so far and returns whether it did.
+//An id is pushed once per search, the indexes skip repeated candidates with a Visited_Set.
+bool KNN_Heap::push(uint32_t id, double distance) {
+	if (distance >= get_threshold()) {
+		return false;
+	}
+	if (size < capacity) {
+		neighbours[size].id = id;
+		neighbours[size].distance = distance;
+		size++;
+	}
+	else {
+		pop_heap(neighbours.begin(), neighbours.begin() + size, closer);
+		neighbours[size - 1].id = id;
+		neighbours[size - 1].distance = distance;
+	}
+	push_heap(neighbours.begin(), neighbours.begin() + size, closer);
+	return true;
+}
+
+double KNN_Heap::get_threshold() const {
+	if (size < capacity) {
+		return numeric_limits<double>::max();
+	}
+	if (capacity == 0) {
+		return -numeric_limits<double>::max();
+	}
+	return neighbours[0].distance;
+}
+
+//nearest first. The heap order is gone afterwards, so it is called once the search is over
+void KNN_Heap::sort() {
+	sort_heap(neighbours.begin(), neighbours.begin() + size, closer);
+}
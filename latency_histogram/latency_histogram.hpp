@@ -0,0 +1,53 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "../query_result/query_result.hpp"
+
+using namespace std;
+
+//every power of two of nanoseconds is split in 2^LATENCY_SUB_BUCKET_BITS buckets, so a
+//reported latency is at most 1/32 above the real one. Latencies of more than
+//2^LATENCY_MAX_EXPONENT ns (about 73 minutes) go to the last bucket.
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_EXPONENT 42
+#define LATENCY_BUCKETS ((LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 2)*LATENCY_SUB_BUCKETS)
+
+//log bucketed counts of query latencies (HDR style). record() is a relaxed atomic add,
+//so the threads of a pool record into the same histogram without a lock.
+class Latency_Histogram {
+public:
+	Latency_Histogram();
+
+	void record(double seconds);
+	void merge(const Latency_Histogram& histogram);
+	//seconds below which the given fraction of the latencies is, 0 when empty
+	double percentile(double fraction) const;
+	double get_max() const {return max_nanoseconds.load()/1e9;}
+	double get_mean() const;
+	uint64_t get_count() const {return count.load();}
+private:
+	Latency_Histogram(const Latency_Histogram&);
+	Latency_Histogram& operator=(const Latency_Histogram&);
+
+	static int bucket(uint64_t nanoseconds);
+	static uint64_t highest_value(int bucket);
+
+	atomic<uint64_t> buckets[LATENCY_BUCKETS];
+	atomic<uint64_t> count;
+	atomic<uint64_t> total_nanoseconds;
+	atomic<uint64_t> max_nanoseconds;
+};
+
+//records the latency of an ann search in hit or in empty, by whether it found anything
+void record_latency(Query_Result& query_result, Latency_Histogram& hit, Latency_Histogram& empty);
+//"<label>: n <count> mean p50 p90 p99 p99.9 max" in milliseconds
+void print_latencies(const string& label, const Latency_Histogram& histogram);
+//the latencies of all the queries, then of the hits and the empty ones
+void print_latencies(const Latency_Histogram& hit, const Latency_Histogram& empty);
+
+#endif
@@ -0,0 +1,112 @@
+#include <atomic>
+#include <cstdio>
+#include <cmath>
+#include <string>
+
+using namespace std;
+
+#include "latency_histogram.hpp"
+
+Latency_Histogram::Latency_Histogram() {
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		buckets[i] = 0;
+	}
+	count = 0;
+	total_nanoseconds = 0;
+	max_nanoseconds = 0;
+}
+
+//values below LATENCY_SUB_BUCKETS ns are exact, then every power of two 2^e holds
+//LATENCY_SUB_BUCKETS buckets of width 2^(e - LATENCY_SUB_BUCKET_BITS)
+int Latency_Histogram::bucket(uint64_t nanoseconds) {
+	if (nanoseconds < LATENCY_SUB_BUCKETS) {
+		return nanoseconds;
+	}
+	int exponent = 63 - __builtin_clzll(nanoseconds);
+	if (exponent > LATENCY_MAX_EXPONENT) {
+		return LATENCY_BUCKETS - 1;
+	}
+	int shift = exponent - LATENCY_SUB_BUCKET_BITS;
+	return (shift + 1)*LATENCY_SUB_BUCKETS + (int)(nanoseconds >> shift) - LATENCY_SUB_BUCKETS;
+}
+
+uint64_t Latency_Histogram::highest_value(int bucket) {
+	if (bucket < LATENCY_SUB_BUCKETS) {
+		return bucket;
+	}
+	int shift = bucket/LATENCY_SUB_BUCKETS - 1;
+	uint64_t low = (uint64_t)(bucket%LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS) << shift;
+	return low + ((uint64_t)1 << shift) - 1;
+}
+
+void Latency_Histogram::record(double seconds) {
+	uint64_t nanoseconds = seconds > 0 ? (uint64_t)llround(seconds*1e9) : 0;
+	buckets[bucket(nanoseconds)].fetch_add(1, memory_order_relaxed);
+	count.fetch_add(1, memory_order_relaxed);
+	total_nanoseconds.fetch_add(nanoseconds, memory_order_relaxed);
+
+	uint64_t max = max_nanoseconds.load(memory_order_relaxed);
+	while (nanoseconds > max
+			&& max_nanoseconds.compare_exchange_weak(max, nanoseconds, memory_order_relaxed) == false);
+}
+
+void Latency_Histogram::merge(const Latency_Histogram& histogram) {
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		buckets[i].fetch_add(histogram.buckets[i].load(), memory_order_relaxed);
+	}
+	count.fetch_add(histogram.count.load(), memory_order_relaxed);
+	total_nanoseconds.fetch_add(histogram.total_nanoseconds.load(), memory_order_relaxed);
+
+	uint64_t max = max_nanoseconds.load(memory_order_relaxed);
+	uint64_t other = histogram.max_nanoseconds.load();
+	while (other > max && max_nanoseconds.compare_exchange_weak(max, other, memory_order_relaxed) == false);
+}
+
+//the highest value of the bucket that holds the latency of rank ceil(fraction*count),
+//never above the exact max
+double Latency_Histogram::percentile(double fraction) const {
+	uint64_t total = count.load();
+	if (total == 0) {
+		return 0;
+	}
+	uint64_t rank = max((uint64_t)1, (uint64_t)ceil(fraction*total));
+	uint64_t seen = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += buckets[i].load(memory_order_relaxed);
+		if (seen >= rank) {
+			return min(highest_value(i), max_nanoseconds.load())/1e9;
+		}
+	}
+	return get_max();
+}
+
+double Latency_Histogram::get_mean() const {
+	uint64_t total = count.load();
+	return total == 0 ? 0 : total_nanoseconds.load()/1e9/total;
+}
+
+void record_latency(Query_Result& query_result, Latency_Histogram& hit, Latency_Histogram& empty) {
+	if (query_result.get_time() == -1) {
+		empty.record(query_result.get_latency());
+	}
+	else {
+		hit.record(query_result.get_latency());
+	}
+}
+
+void print_latencies(const string& label, const Latency_Histogram& histogram) {
+	printf("%s: n %llu, mean %.4f, p50 %.4f, p90 %.4f, p99 %.4f, p99.9 %.4f, max %.4f ms\n", label.c_str(),
+		(unsigned long long)histogram.get_count(), histogram.get_mean()*1e3, histogram.percentile(0.5)*1e3,
+		histogram.percentile(0.9)*1e3, histogram.percentile(0.99)*1e3, histogram.percentile(0.999)*1e3,
+		histogram.get_max()*1e3);
+	fflush(stdout);
+}
+
+void print_latencies(const Latency_Histogram& hit, const Latency_Histogram& empty) {
+	Latency_Histogram all;
+	all.merge(hit);
+	all.merge(empty);
+	print_latencies("Query latency", all);
+	print_latencies("Query latency (hit)", hit);
+	print_latencies("Query latency (empty)", empty);
+}
@@ -3,24 +3,45 @@
 
 #include "../query_result/query_result.hpp"
 #include "../hash_table_vector/hash_table_vector.hpp"
+#include "../dataset/dataset.hpp"
+#include "../hash_engine/hash_engine.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../index_file/index_file.hpp"
 #include <list>
 using namespace std;
-class LSH {
+//the index of a Dataset<T>, instantiated for double, float, int16_t and uint8_t
+template <typename T> class LSH {
 public:
-	LSH(int L, int dimension, int w, int k, unsigned m);
+	LSH(int L, Dataset<T> *dataset, int w, int k, unsigned m);
 	~LSH();
 
-	void insert_item(Item *item);
-	void ANN(Item *query, unsigned threshhold, Query_Result& query_result);
-	void range_search(Item *query, unsigned threshhold, float radious,
-		list<Item*>& range_items, Query_Result& query_result);
+	//items inserted one by one are searched only after freeze()
+	void insert_item(uint32_t id);
+	void freeze();
+	void build(int threads);
+	//dataset_hash is hash_file() of the file of the dataset, load() fails when it differs
+	bool save(const string& file_name, uint64_t dataset_hash);
+	static LSH* load(const string& file_name, Dataset<T> *dataset, uint64_t dataset_hash);
+	//the queries only read the index, so many threads can run them at once. They
+	//return false and search nothing while the index is not frozen
+	bool kANN(const T *query, unsigned threshhold, int num_of_probes,
+		KNN_Heap& neighbours) const;
+	bool ANN(const T *query, unsigned threshhold, int num_of_probes,
+		Query_Result& query_result) const;
+	bool range_search(const T *query, unsigned threshhold, float radious,
+		list<uint32_t>& range_items, Query_Result& query_result) const;
 	void print_hash_tables();
-	int get_w() {return w;}
-	int get_k() {return k;}
-	int get_dimension() {return dimension;}
+	int get_L() const {return L;}
+	int get_w() const {return w;}
+	int get_k() const {return k;}
+	int get_dimension() const {return dimension;}
+	bool is_frozen() const {return frozen;}
 private:
-	unsigned long long int lsh_distance(Item *item1, Item *item2);
-	vector<Hash_Table*> hash_tables;
+	double lsh_distance(const T *x1, const T *x2, double threshold) const;
+	vector<Hash_Table_Vector*> hash_tables;
+	Hash_Engine *hash_engine;
+	Index_Reader *index_file; //mapped file of a loaded index, owns its buckets
+	Dataset<T> *dataset;
 	int w;
 	int k;
 	int dimension;
@@ -28,6 +49,6 @@ private:
 	int bits_of_each_hash;
 	unsigned long M;
 	unsigned m;
-	vector<unsigned> m_powers;
+	bool frozen;
 };
 #endif
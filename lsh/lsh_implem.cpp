@@ -8,136 +8,282 @@
 using namespace std;
 
 #include "../item/item.hpp"
+#include "../dataset/dataset.hpp"
 #include "../hash_table_vector/hash_table_vector.hpp"
+#include "../hash_engine/hash_engine.hpp"
 #include "../helping_functions/helping_functions.hpp"
 #include "../query_result/query_result.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../visited_set/visited_set.hpp"
 #include "lsh.hpp"
 
-LSH::LSH(int L, int dimension, int w, int k, unsigned m) {
+//items hashed by one task of the bulk build
+#define BUILD_BLOCK 1024
+
+template <typename T> LSH<T>::LSH(int L, Dataset<T> *dataset, int w, int k, unsigned m) {
+	int dimension = dataset->get_dimension();
 	for (size_t i = 0; i < L; i++) {
-		Hash_Table *hash_table = new Hash_Table(dimension, w, k);
+		Hash_Table_Vector *hash_table = new Hash_Table_Vector(dimension, w, k);
 		hash_tables.push_back(hash_table);
 	}
 	this->L = L;
+	this->dataset = dataset;
 	this->dimension = dimension;
 	this->w = w;    
 	this->k = k;
 	this->bits_of_each_hash = 32/k;
 	if (k == 1) {
-		this->M = numeric_limits<unsigned>::max() + 1;
+		this->M = (unsigned long)numeric_limits<unsigned>::max() + 1;
 	}
 	else {
 		this->M = pow(2, bits_of_each_hash);
 	}
 	this->m = m;
-	for (size_t i = 0; i < dimension; i++) {
-		m_powers.push_back( pow_mod(m, i, M) );
+	this->frozen = false;
+	this->index_file = NULL;
+	this->hash_engine = new Hash_Engine(L, dimension, w, k, M, m);
+	for (size_t i = 0; i < L; i++) {
+		hash_engine->set_s_array(i, hash_tables[i]->get_s_array());
 	}
 }
 
-LSH::~LSH() {
+template <typename T> LSH<T>::~LSH() {
 	for (size_t i = 0; i < L; i++) {
 		delete hash_tables[i];
 	}
+	delete hash_engine;
+	delete index_file;
+}
+
+template <typename T> void LSH<T>::insert_item(uint32_t id) {
+	unsigned g_values[L];
+	hash_engine->g_hash(dataset->get_coordinates(id), g_values);
+	for (size_t i = 0; i < L; i++) {
+		hash_tables[i]->insert(id, g_values[i]);
+	}
+}
+
+//bulk build of the frozen tables from every item of the dataset. The g values of
+//blocks of items are computed in parallel into one (g value, id) array per table,
+//each slot written by one thread only, then every table sorts its own array.
+template <typename T> void LSH<T>::build(int threads) {
+	uint32_t size = dataset->get_size();
+	vector<vector<pair<unsigned, uint32_t>>> entries(L);
+	for (size_t i = 0; i < L; i++) {
+		entries[i].resize(size);
+	}
+
+	Thread_Pool thread_pool(threads);
+	uint32_t num_of_blocks = (size + BUILD_BLOCK - 1)/BUILD_BLOCK;
+	thread_pool.run(num_of_blocks, [&](uint32_t block) {
+		unsigned g_values[L];
+		uint32_t end = min(size, (block + 1)*BUILD_BLOCK);
+		for (uint32_t id = block*BUILD_BLOCK; id < end; id++) {
+			hash_engine->g_hash(dataset->get_coordinates(id), g_values);
+			for (size_t i = 0; i < L; i++) {
+				entries[i][id] = make_pair(g_values[i], id);
+			}
+		}
+	});
+
+	thread_pool.run(L, [&](uint32_t i) {
+		hash_tables[i]->build(entries[i]);
+		vector<pair<unsigned, uint32_t>>().swap(entries[i]);
+	});
+	frozen = true;
+}
+
+//writes the index to a binary file that load() maps back in place
+template <typename T> bool LSH<T>::save(const string& file_name, uint64_t dataset_hash) {
+	Index_Writer writer;
+	if (frozen == false) {
+		freeze();
+	}
+	if (writer.open(file_name, INDEX_FILE_LSH) == false) {
+		return false;
+	}
+	writer.write_value<int32_t>(L);
+	writer.write_value<int32_t>(k);
+	writer.write_value<int32_t>(w);
+	writer.write_value<int32_t>(dimension);
+	writer.write_value<uint64_t>(M);
+	writer.write_value<uint32_t>(m);
+	writer.write_value<uint32_t>(dataset->get_size());
+	writer.write_value<uint32_t>(Element_Type<T>::code);
+	writer.write_value<uint64_t>(dataset_hash);
+	for (size_t i = 0; i < L; i++) {
+		hash_tables[i]->save(writer);
+	}
+	return writer.close();
+}
+
+//opens an index written by save() for the same dataset file and element type. The buckets stay
+//in the mapped file, so only the pages the queries touch are read. NULL when the file does not fit
+template <typename T> LSH<T>* LSH<T>::load(const string& file_name, Dataset<T> *dataset,
+		uint64_t dataset_hash) {
+	Index_Reader *reader = new Index_Reader();
+	int32_t L, k, w, dimension;
+	uint64_t M, file_dataset_hash;
+	uint32_t m, size, element_type;
+
+	if (reader->open(file_name, INDEX_FILE_LSH) == false
+			|| reader->read_value(L) == false || L < 1 || reader->read_value(k) == false || k < 1 || k > 32
+			|| reader->read_value(w) == false || reader->read_value(dimension) == false
+			|| reader->read_value(M) == false || reader->read_value(m) == false
+			|| reader->read_value(size) == false || reader->read_value(element_type) == false
+			|| reader->read_value(file_dataset_hash) == false
+			|| dimension != dataset->get_dimension() || size != dataset->get_size()
+			|| element_type != Element_Type<T>::code || file_dataset_hash != dataset_hash) {
+		delete reader;
+		return NULL;
+	}
+
+	LSH *lsh = new LSH(L, dataset, w, k, m);
+	lsh->index_file = reader;
+	if (lsh->M != M) {
+		delete lsh;
+		return NULL;
+	}
+	for (size_t i = 0; i < L; i++) {
+		if (lsh->hash_tables[i]->load(*reader, size) == false) {
+			delete lsh;
+			return NULL;
+		}
+		lsh->hash_engine->set_s_array(i, lsh->hash_tables[i]->get_s_array());
+	}
+	lsh->frozen = true;
+	return lsh;
 }
 
-void LSH::insert_item(Item *item) {
-	unsigned g_value;
+//turns every table into its read-only sorted form, called once after the bulk insert
+template <typename T> void LSH<T>::freeze() {
 	for (size_t i = 0; i < L; i++) {
-		g_value = g_hash_function(*(item->get_coordinates()), dimension,
-			w, k, bits_of_each_hash, M, hash_tables[i]->get_s_array(), m_powers);
-		hash_tables[i]->insert(item, g_value);
+		hash_tables[i]->freeze();
 	}
+	frozen = true;
 }
 
-void LSH::ANN(Item *query, unsigned threshhold, Query_Result& query_result) {
+//the capacity of neighbours nearest items found in the bucket of the query in every
+//table and, with num_of_probes > 0, in the num_of_probes neighbouring buckets the
+//query is most likely to have missed
+template <typename T> bool LSH<T>::kANN(const T *query, unsigned threshhold, int num_of_probes,
+		KNN_Heap& neighbours) const {
 	unsigned searched_items;
-	unsigned best_distance = numeric_limits<unsigned>::max();
-	unsigned position, g_value;
-	string best = "";
-	unordered_multimap<unsigned, Item*> *map;
-	pair <unordered_multimap<unsigned, Item*>::iterator, unordered_multimap<unsigned,Item*>::iterator> ret;
-	unordered_multimap<unsigned, Item*>::iterator it;
+	const uint32_t *begin, *end, *it;
+
+	if (frozen == false) {
+		return false;
+	}
 
-	time_t time;
-	time = clock();
+	//clamped before sizing anything, a large -probes asks for no more than exists
+	num_of_probes = min(max(num_of_probes, 0), hash_engine->get_max_probes());
+	unsigned g_values[L];
+	static thread_local vector<unsigned> probe_buffer;
+	if (probe_buffer.size() < (size_t)L*num_of_probes) {
+		probe_buffer.resize((size_t)L*num_of_probes);
+	}
+	unsigned *probe_values = probe_buffer.data();
+	num_of_probes = hash_engine->g_probe(query, num_of_probes, g_values, probe_values);
+	Visited_Set& visited_set = get_visited_set();
+	visited_set.start(dataset->get_size());
 	for (size_t i = 0; i < L; i++) {
-		g_value = g_hash_function(*(query->get_coordinates()),
-				dimension, w, k, bits_of_each_hash, M, hash_tables[i]->get_s_array(), m_powers);
-		
-		map = hash_tables[i]->get_map();
-		ret = map->equal_range(g_value);
 		searched_items = 0;
-		for (it = ret.first; it != ret.second; ++it) {
-			if (searched_items >= threshhold) {
-				goto exit;
-			}
+		for (int probe = -1; probe < num_of_probes; probe++) {
+			unsigned g_value = probe == -1 ? g_values[i] : probe_values[i*num_of_probes + probe];
+			hash_tables[i]->get_bucket(g_value, &begin, &end);
+			for (it = begin; it != end; ++it) {
+				if (searched_items >= threshhold) {
+					return true;
+				}
+				//already measured through another table
+				if (visited_set.visit(*it) == false) {
+					continue;
+				}
 
-			unsigned cur_distance = lsh_distance(query, it->second);
-			if (cur_distance < best_distance) {
-				best = it->second->get_name();
-				best_distance = cur_distance;
+				double cur_distance = lsh_distance(query, dataset->get_coordinates(*it),
+					neighbours.get_threshold());
+				neighbours.push(*it, cur_distance);
+				searched_items++;
 			}
-			searched_items++;
 		}
 	}
-	exit:
-	time = clock() - time;
+	return true;
+}
 
-	if (best != "") {
-		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
-		query_result.set_best_item(best);
+template <typename T> bool LSH<T>::ANN(const T *query, unsigned threshhold, int num_of_probes,
+		Query_Result& query_result) const {
+	KNN_Heap neighbours(1);
+
+	double time;
+	time = get_wall_time();
+	bool searched = kANN(query, threshhold, num_of_probes, neighbours);
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
+
+	if (neighbours.get_size() != 0) {
+		query_result.set_best_distance(neighbours.get_neighbour(0).distance);
+		query_result.set_time(time);
+		query_result.set_best_item(dataset->get_name(neighbours.get_neighbour(0).id));
 	}
 	else {
 		query_result.set_best_distance(-1);
 		query_result.set_time(-1);
 		query_result.set_best_item("NULL");
 	}
+	return searched;
 }
 
-void LSH::print_hash_tables() {
+template <typename T> void LSH<T>::print_hash_tables() {
 	for (size_t i = 0; i < L; i++) {
 		cout <<"Hash table: "<<i<<endl;
 		hash_tables[i]->print();
 	}
 }
 
-unsigned long long int LSH::lsh_distance(Item *item1, Item *item2) {
-	return manhattan_distance(*(item1->get_coordinates()), *(item2->get_coordinates()));
+template <typename T> double LSH<T>::lsh_distance(const T *x1, const T *x2, double threshold) const {
+	return manhattan_distance(x1, x2, dimension, threshold);
 }
 
-void LSH::range_search(Item *query, unsigned threshhold, float radious,
-		list<Item*>& range_items, Query_Result& query_result) {
+template <typename T> bool LSH<T>::range_search(const T *query, unsigned threshhold, float radious,
+		list<uint32_t>& range_items, Query_Result& query_result) const {
 	unsigned searched_items;
 	unsigned best_distance = numeric_limits<unsigned>::max();
-	unsigned position, g_value;
 	string best = "";
-	pair <unordered_multimap<unsigned, Item*>::iterator, unordered_multimap<unsigned,Item*>::iterator> ret;
-	unordered_multimap<unsigned, Item*>::iterator it;
+	const uint32_t *begin, *end, *it;
+
+	if (frozen == false) {
+		return false;
+	}
 
-	time_t time;
-	time = clock();
+	unsigned g_values[L];
+	double time;
+	time = get_wall_time();
+	hash_engine->g_hash(query, g_values);
+	Visited_Set& visited_set = get_visited_set();
+	visited_set.start(dataset->get_size());
 	for (size_t i = 0; i < L; i++) {
-		g_value = g_hash_function(*(query->get_coordinates()),
-				dimension, w, k, bits_of_each_hash, M, hash_tables[i]->get_s_array(), m_powers);
-		
-		ret = hash_tables[i]->get_map()->equal_range(g_value);
+		hash_tables[i]->get_bucket(g_values[i], &begin, &end);
 		searched_items = 0;
-		for (it = ret.first; it != ret.second; ++it) {
-			unsigned cur_distance = lsh_distance(query, it->second);
+		for (it = begin; it != end; ++it) {
+			if (visited_set.visit(*it) == false) {
+				continue;
+			}
+			double cur_distance = lsh_distance(query, dataset->get_coordinates(*it),
+				radious);
 			if (cur_distance < radious) {
-				range_items.push_back(it->second);
+				range_items.push_back(*it);
 			}
 			searched_items++;
 		}
 	}
 	exit:
-	time = clock() - time;
+	time = get_wall_time() - time;
+	query_result.set_latency(time);
 
 	if (best != "") {
 		query_result.set_best_distance(best_distance);
-		query_result.set_time( ((double)time) / CLOCKS_PER_SEC );
+		query_result.set_time(time);
 		query_result.set_best_item(best);
 	}
 	else {
@@ -145,4 +291,10 @@ void LSH::range_search(Item *query, unsigned threshhold, float radious,
 		query_result.set_time(-1);
 		query_result.set_best_item("NULL");
 	}
-}
\ No newline at end of file
+	return true;
+}
+
+template class LSH<double>;
+template class LSH<float>;
+template class LSH<int16_t>;
+template class LSH<uint8_t>;
@@ -8,112 +8,213 @@
 #include <cstdio>
 #include <unordered_map>
 #include <limits>
+#include <thread>
 
 using namespace std;
 
 #include "../query_result/query_result.hpp"
 #include "../item/item.hpp"
+#include "../dataset/dataset.hpp"
 #include "../lsh/lsh.hpp"
 #include "../hash_table_vector/hash_table_vector.hpp"
 #include "../helping_functions/helping_functions.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../exact_search/exact_search.hpp"
+#include "../ground_truth/ground_truth.hpp"
+#include "../latency_histogram/latency_histogram.hpp"
+#include "../w_estimator/w_estimator.hpp"
 
 #define L_DEFAULT 5
 #define K_DEFAULT 4
 #define W_DEFAULT 4300
 #define SEARCH_THRESHOLD (L_DEFAULT*100)
+#define THREADS_DEFAULT 1
+#define PROBES_DEFAULT 0
+#define NEIGHBOURS_DEFAULT 1
+//an estimated w is this many mean nearest neighbour distances wide
+#define W_NEAREST_NEIGHBOUR_FACTOR 4
 
-int main(int argc, char *argv[]) {
+//the whole program for vectors of T
+template <typename T> static int run(int argc, char *argv[]) {
 	int L = L_DEFAULT;
 	int k = K_DEFAULT;
 	int w = W_DEFAULT;
 	int search_threshold = SEARCH_THRESHOLD;
+	int threads = THREADS_DEFAULT;
+	int probes = PROBES_DEFAULT;
+	int num_of_neighbours = NEIGHBOURS_DEFAULT;
+	int w_samples = W_SAMPLES_DEFAULT;
 	float radious = -1;
+	bool exact = false;
 	int PRINT_ON_SCREAN = 0;
 
-	if (argc < 5 ) {
-		cout <<"usage: ./lsh –d <input file> –q <query file> –k <int> -L <int> -ο <output file>"<<endl;
-		return 1;
-	}
-
 	//READ COMMAND LINE ARGUMENTS
 	string input_file, query_file, output_file = "";
+	string save_index_file = "", load_index_file = "";
+	string ground_truth_file = "";
 	read_command_line_arguments(argv, argc, input_file, query_file, output_file,
-			k, L, w, search_threshold);
+			k, L, w, search_threshold, probes, num_of_neighbours, save_index_file,
+			load_index_file, threads, exact, ground_truth_file, w_samples);
 
 	if( output_file == "" ){
 		PRINT_ON_SCREAN = 1;
 	}
 	//READ ITEMS FROM THE INPUT FILE
-	list<Item*> input_items;
+	Dataset<T> input_items;
 	read_vectors_from_file(input_file, input_items);
-	int dimension = input_items.front()->get_coordinates()->size();
+	if (input_items.get_size() == 0) {
+		cout <<"No vectors in the input file: "<<input_file<<endl;
+		return 1;
+	}
+	int dimension = input_items.get_dimension();
 	unsigned m = numeric_limits<unsigned>::max() + 1 - 5;
-	search_threshold = max((int)input_items.size()/10, search_threshold);
-	if (w == -1) {
-		w = calculate_w(input_items);
+	search_threshold = max((int)input_items.get_size()/10, search_threshold);
+
+	LSH<T> *lsh;
+	double time = get_wall_time();
+	if (load_index_file != "") {
+		//LOAD THE LSH STRUCTURE, ITS PARAMETERS COME FROM THE FILE
+		lsh = LSH<T>::load(load_index_file, &input_items, hash_file(input_file));
+		if (lsh == NULL) {
+			cout <<"Index loading error: "<<load_index_file<<endl;
+			return 1;
+		}
+		time = get_wall_time() - time;
+		print_parameters(lsh->get_L(), lsh->get_k(), lsh->get_w(), search_threshold, dimension);
+		cout <<"Index loading total time: "<< time <<endl;
 	}
-	print_parameters(L, k, w, search_threshold, dimension);
+	else {
+		if (w == -1) {
+			//mean nearest neighbour distance of a sample, on every core
+			Thread_Pool estimate_thread_pool(max(1u, thread::hardware_concurrency()));
+			double estimate_time = get_wall_time();
+			W_Estimate estimate = estimate_w(&input_items, w_samples, estimate_thread_pool);
+			estimate_time = get_wall_time() - estimate_time;
+			w = max(1, (int)round(W_NEAREST_NEIGHBOUR_FACTOR*estimate.mean));
+			cout <<"w estimate: "<<estimate.mean<<" (95% confidence "<<estimate.low<<" - "<<estimate.high
+				<<", "<<estimate.samples<<" samples, "<<estimate_time<<" s)"<<endl;
+		}
+		print_parameters(L, k, w, search_threshold, dimension);
 
-	//CREATE THE LSH STRUCTURE
-	LSH lsh(L, dimension, w, k, m);
+		//CREATE THE LSH STRUCTURE
+		lsh = new LSH<T>(L, &input_items, w, k, m);
 
-	//INSERT INPUT DATA
-	time_t time = clock();
-	for(Item *item: input_items) {
-		lsh.insert_item(item);
+		//INSERT INPUT DATA
+		lsh->build(threads);
+		time = get_wall_time() - time;
+		cout <<"Data insertion total time: "<< time <<endl;
+	}
+	if (save_index_file != "" && lsh->save(save_index_file, hash_file(input_file)) == false) {
+		cout <<"Index saving error: "<<save_index_file<<endl;
+		return 1;
 	}
-	time = clock() - time;
-	cout <<"Data insertion total time: "<< ((double)time) / CLOCKS_PER_SEC <<endl<<endl;
+	cout <<"element type: "<<get_element_type_name(Element_Type<T>::code)<<endl;
+	cout <<"distance kernel: "<<get_distance_kernel_name<T>()<<endl;
+	cout <<"probes per table: "<<probes<<endl;
+	cout <<"search: "<<(exact ? "exact" : "lsh")<<endl<<endl;
 
 
 	//HANDLE QUERIES
-	list<Item*> queries;
+	Dataset<T> queries;
 	read_vectors_from_file(query_file, queries, radious);
 	if (radious != -1) {
 		cout <<"Radious: "<<radious<<endl;
 	}
 
-	Query_Result ann_query_result, exhaustive_query_result;
-	Query_Result range_query_result;
-	time = clock();
+	//answer the queries in parallel, every query has its own results
+	uint32_t num_of_queries = queries.get_size();
+	vector<Query_Result> ann_query_results(num_of_queries);
+	vector<Query_Result> exhaustive_query_results(num_of_queries);
+	vector<Query_Result> range_query_results(num_of_queries);
+	vector<list<uint32_t>> range_items(num_of_queries);
+	vector<double> recalls(num_of_queries);
+	double wall_time = get_wall_time();
+
+	//Exact nearest neighbours of all the queries, from the ground truth file when it has
+	//them or in tiles on every core. Text files read as another element type are rounded,
+	//so their ground truth is kept apart.
+	vector<KNN_Heap> exact_neighbours(num_of_queries, KNN_Heap(max(num_of_neighbours, 1)));
+	vector<double> exact_times(num_of_queries);
+	double exact_time = get_wall_time();
+	Thread_Pool exact_thread_pool(max(1u, thread::hardware_concurrency()));
+	uint64_t variant = Element_Type<T>::code == DATASET_FILE_DOUBLE ? 0 : Element_Type<T>::code;
+	get_ground_truth(ground_truth_file, input_file, query_file, variant, input_items.get_size(), exact_neighbours, exact_times, [&] {
+		exact_search(&input_items, &queries, exact_neighbours, exact_times, exact_thread_pool);
+	});
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		ground_truth_result(exact_neighbours[query_id], exact_times[query_id], &input_items,
+			exhaustive_query_results[query_id]);
+	}
+	exact_time = get_wall_time() - exact_time;
+
+	Latency_Histogram hit_latencies, empty_latencies;
+	Thread_Pool thread_pool(threads);
+	thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+		const T *query = queries.get_coordinates(query_id);
+
+		//approximate nearest neighbor, the exact one in the exact mode
+		if (exact) {
+			ann_query_results[query_id] = exhaustive_query_results[query_id];
+		}
+		else {
+			lsh->ANN(query, search_threshold, probes, ann_query_results[query_id]);
+			record_latency(ann_query_results[query_id], hit_latencies, empty_latencies);
+		}
+
+		//recall@k of the k nearest neighbours
+		if (num_of_neighbours > 1) {
+			KNN_Heap approximate(num_of_neighbours);
+			if (exact) {
+				approximate = exact_neighbours[query_id];
+			}
+			else {
+				lsh->kANN(query, search_threshold, probes, approximate);
+			}
+			recalls[query_id] = recall(approximate, exact_neighbours[query_id]);
+		}
+
+		//range search (Bonus)
+		if (radious > 0) {
+			lsh->range_search(query, search_threshold, radious, range_items[query_id],
+				range_query_results[query_id]);
+		}
+	});
+	wall_time = get_wall_time() - wall_time;
+
+	//print the results and the statistics in query order
 	double sum_query_time = 0;
 	double max_rate = -1;
 	double sum_rate = 0;
 	int found_nearest = 0;
 	int total_distances = 0;
 	int not_null = 0;
-	list<Item*> range_items;
+	double sum_recall = 0;
 	FILE *out = fopen(output_file.c_str(), "w");
-	for(Item *query: queries) {
-		//approximate nearest neighbor
-		lsh.ANN(query, search_threshold, ann_query_result);
-
-		//Exact nearest neighbor
-		exhaustive_search(&input_items, query, exhaustive_query_result);
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		Query_Result& ann_query_result = ann_query_results[query_id];
+		Query_Result& exhaustive_query_result = exhaustive_query_results[query_id];
 
 		if(PRINT_ON_SCREAN==1){
-			print_results(query->get_name(), ann_query_result, "LSH",
+			print_results(queries.get_name(query_id), ann_query_result, "LSH",
 				exhaustive_query_result);
 		}
 		else {
-			print_results_to_file(query->get_name(), ann_query_result, "LSH",
+			print_results_to_file(queries.get_name(query_id), ann_query_result, "LSH",
 				out ,exhaustive_query_result);
 		}
 
-		//range search (Bonus)
 		if (radious > 0) {
-			lsh.range_search(query, search_threshold, radious, range_items, range_query_result);
-
 			if(PRINT_ON_SCREAN ==1) {
-				print_range_results(range_items, radious);
+				print_range_results(range_items[query_id], &input_items, radious);
 			}
 			else {
-				print_range_results_to_file(range_items, out,radious);
+				print_range_results_to_file(range_items[query_id], &input_items, out, radious);
 			}
-
-			range_items.clear();
 		}
 
+		sum_recall += recalls[query_id];
+
 		//statistics info
 		if (ann_query_result.get_time() != -1) {
 			sum_query_time += ann_query_result.get_time();
@@ -130,18 +231,40 @@ int main(int argc, char *argv[]) {
 
 	}
 
-	time = clock() - time;
-	cout <<"Handling of queries(ann and enn) total time: "<< ((double)time) / CLOCKS_PER_SEC<<endl;
+	cout <<"Handling of queries(ann and enn) total time: "<< wall_time
+		<<" ("<<thread_pool.get_num_of_threads()<<" threads)"<<endl;
+	cout <<"Exact search total time: "<< exact_time
+		<<" ("<<exact_thread_pool.get_num_of_threads()<<" threads)"<<endl;
 	cout << "Average query time: "<<sum_query_time/not_null<<endl;
 	cout << "Max AF: "<<max_rate<<endl;
 	cout << "Average AF: "<<sum_rate/not_null<<endl;
-	cout << "Found "<<not_null<<"/"<<queries.size()<<" approximate nearest neighbors"<<endl;
-	cout << "Found "<<found_nearest<<"/"<<queries.size()<<" exact nearest neighbors"<<endl;
-	cout << "Average distance: "<<total_distances/queries.size()<<endl;
+	cout << "Found "<<not_null<<"/"<<queries.get_size()<<" approximate nearest neighbors"<<endl;
+	cout << "Found "<<found_nearest<<"/"<<queries.get_size()<<" exact nearest neighbors"<<endl;
+	cout << "Average distance: "<<total_distances/queries.get_size()<<endl;
+	print_latencies(hit_latencies, empty_latencies);
+	if (num_of_neighbours > 1) {
+		cout << "Recall@"<<num_of_neighbours<<": "<<sum_recall/queries.get_size()<<endl;
+	}
 	cout <<"--------------------------------------------------------------------------"<<endl;
 	cout <<endl;
 
-	delete_items(input_items);
-	delete_items(queries);
+	delete lsh;
 	return 0;
 }
+
+int main(int argc, char *argv[]) {
+	if (argc < 5 ) {
+		cout <<"usage: ./lsh –d <input file> –q <query file> –k <int> -L <int> -ο <output file> -probes <int> -kNN <int> --save-index <file> --load-index <file> -threads <int> -exact -gt <file> -w <int, -1 to estimate it> -w_samples <int> -type <double|float|int16|uint8>"<<endl;
+		return 1;
+	}
+
+	//THE ELEMENT TYPE OF THE VECTORS, FROM -type OR THE INPUT FILE
+	switch (read_element_type(argv, argc)) {
+		case DATASET_FILE_DOUBLE: return run<double>(argc, argv);
+		case DATASET_FILE_FLOAT: return run<float>(argc, argv);
+		case DATASET_FILE_INT16: return run<int16_t>(argc, argv);
+		case DATASET_FILE_UINT8: return run<uint8_t>(argc, argv);
+	}
+	cout <<"Unknown element type, expected double, float, int16 or uint8"<<endl;
+	return 1;
+}
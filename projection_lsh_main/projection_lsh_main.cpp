@@ -17,6 +17,9 @@ using namespace std;
 #include "../Tuple/tuple.hpp"
 #include "../lsh/lsh.hpp"
 #include "../curve_projection_lsh/curve_projection_lsh.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../ground_truth/ground_truth.hpp"
+#include "../latency_histogram/latency_histogram.hpp"
 
 #define L_DEFAULT 5
 #define K_DEFAULT 4
@@ -25,6 +28,7 @@ using namespace std;
 #define CURVE_DIMENSION_DEFAULT 2
 #define EPS_DEFAULT 0.5
 #define M_TABLE_DEFAULT 6
+#define THREADS_DEFAULT 1
 
 
 int main(int argc, char *argv[]) {
@@ -32,6 +36,7 @@ int main(int argc, char *argv[]) {
 	int k = K_DEFAULT;
 	int w = W_DEFAULT;
 	int search_threshold = SEARCH_THRESHOLD;
+	int threads = THREADS_DEFAULT;
 	int curve_dimension = CURVE_DIMENSION_DEFAULT;
     float eps = EPS_DEFAULT;
 	int M_table = M_TABLE_DEFAULT;
@@ -43,8 +48,9 @@ int main(int argc, char *argv[]) {
 
 	//READ COMMAND LINE ARGUMENTS
 	string input_file, query_file, output_file;
+	string ground_truth_file;
 	read_command_line_arguments(argv, argc, input_file, query_file, output_file,
-			k, L, w, search_threshold, eps, M_table);
+			k, L, w, search_threshold, eps, M_table, threads, ground_truth_file);
 
 	//READ CURVES FROM THE INPUT FILE
 	list<Curve*> input_curves;
@@ -68,20 +74,55 @@ int main(int argc, char *argv[]) {
 
 
 	//INSERT INPUT DATA
-	time_t time = clock();
+	double time = get_wall_time();
 	for(Curve *curve : input_curves) {
 		grid_projection.insert_curve(curve);
 	}
-	time = clock() - time;
-	cout <<"Data insertion time: "<< ((double)time) / CLOCKS_PER_SEC <<endl<<endl;
+	grid_projection.freeze();
+	time = get_wall_time() - time;
+	cout <<"Data insertion time: "<< time <<endl<<endl;
 
 	//READ QUERY CURVES FROM THE INPUT FILE
 	list<Curve*> queries;
 	read_2d_curves_from_file(query_file, queries, max_curve_length, M_table);
 
 	//HANDLE QUERIES
-	Query_Result ann_query_result, exhaustive_query_result;
-	time = clock();
+	//answer the queries in parallel, every query has its own results
+	vector<Curve*> query_curves(queries.begin(), queries.end());
+	uint32_t num_of_queries = query_curves.size();
+	vector<Query_Result> ann_query_results(num_of_queries);
+	vector<Query_Result> exhaustive_query_results(num_of_queries);
+	double wall_time = get_wall_time();
+	Latency_Histogram hit_latencies, empty_latencies;
+	Thread_Pool thread_pool(threads);
+
+	//Exact nearest neighbours, from the ground truth file when it has them
+	vector<Curve*> curves_by_id(input_curves.begin(), input_curves.end());
+	vector<KNN_Heap> exact_neighbours(num_of_queries, KNN_Heap(1));
+	vector<double> exact_times(num_of_queries);
+	get_ground_truth(ground_truth_file, input_file, query_file, M_table, input_curves.size(), exact_neighbours, exact_times, [&] {
+		thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+			double time = get_thread_time();
+			exhaustive_curve_search_k(&input_curves, query_curves[query_id], exact_neighbours[query_id]);
+			exact_neighbours[query_id].sort();
+			exact_times[query_id] = get_thread_time() - time;
+		});
+	});
+
+	thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+		Curve *query = query_curves[query_id];
+
+		//approximate nearest neighbor
+		grid_projection.ANN(query, search_threshold, ann_query_results[query_id]);
+		record_latency(ann_query_results[query_id], hit_latencies, empty_latencies);
+
+		//Exact nearest neighbor
+		ground_truth_result(exact_neighbours[query_id], exact_times[query_id], curves_by_id,
+			exhaustive_query_results[query_id]);
+	});
+	wall_time = get_wall_time() - wall_time;
+
+	//print the results and the statistics in query order
 	double sum_query_time = 0;
 	double max_rate = -1;
 	double sum_rate = 0;
@@ -89,12 +130,10 @@ int main(int argc, char *argv[]) {
 	double total_distances = 0;
 	int not_null = 0;
 	FILE *out = fopen(output_file.c_str(), "w");
-	for(Curve *query: queries) {
-		//Approximate nearest neighbor
-		grid_projection.ANN(query, search_threshold, ann_query_result);
-
-		//Exact nearest neighbor
-		exhaustive_curve_search(&input_curves, query, exhaustive_query_result);
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		Curve *query = query_curves[query_id];
+		Query_Result& ann_query_result = ann_query_results[query_id];
+		Query_Result& exhaustive_query_result = exhaustive_query_results[query_id];
 
 		if (output_file != "") {
 			print_results_to_file(query->get_name(), ann_query_result, "Projection",
@@ -120,15 +159,16 @@ int main(int argc, char *argv[]) {
 			not_null++;
 		}
 	}
-	time = clock() - time;
 	cout <<endl;
-	cout <<"Handling of queries time: "<< ((double)time) / CLOCKS_PER_SEC<<endl;
+	cout <<"Handling of queries time: "<< wall_time
+		<<" ("<<thread_pool.get_num_of_threads()<<" threads)"<<endl;
 	cout << "Average query time: "<<sum_query_time/not_null<<endl;
 	cout << "Max AF: "<<max_rate<<endl;
 	cout << "Average AF: "<<sum_rate/not_null<<endl;
 	cout << "Found "<<not_null<<"/"<<queries.size()<<" approximate nearest neighbors"<<endl;
 	cout << "Found "<<found_nearest<<"/"<<queries.size()<<" exact nearest neighbors"<<endl;
 	cout << "Average distance: "<<total_distances/queries.size()<<endl;
+	print_latencies(hit_latencies, empty_latencies);
 
 	delete_curves(input_curves);
 	delete_curves(queries);
@@ -6,18 +6,21 @@ using namespace std;
 
 class Query_Result {
 public:
-	Query_Result() :best_item("-"){}
+	Query_Result() :best_item("-"), latency(0){}
 	string get_name() {return best_item;}
 	double get_best_distance() {return best_distance;}
 	double get_time() {return time;}
+	double get_latency() {return latency;}
 
 	void set_best_item(string name) {this->best_item = name;}
 	void set_best_distance(double best_distance) {this->best_distance = best_distance;}
 	void set_time(double time) {this->time = time;}
+	void set_latency(double latency) {this->latency = latency;}
 private:
 	string best_item;
 	double best_distance;
-	double time;
+	double time; //-1 when nothing was found
+	double latency; //wall seconds of the search, found or not
 };
 
 #endif
\ No newline at end of file
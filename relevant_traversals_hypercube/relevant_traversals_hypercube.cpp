@@ -3,7 +3,7 @@
 #include "../curve_grid_hypercube/curve_grid_hypercube.hpp"
 using namespace std;
 //class Hash_Table_Hypercube;
-Relevant_Traversals_hypercube::Relevant_Traversals_hypercube(int i, int j, int table_size_hypercube, int K_matrix, int w, int k,int m,int M){
+Relevant_Traversals_hypercube::Relevant_Traversals_hypercube(int i, int j, int table_size_hypercube, int K_matrix, int w, int k,unsigned m,unsigned long M){
 
     find_relevant_traversals(i + 1, j + 1, relevant_traversals);
 
@@ -13,14 +13,8 @@ Relevant_Traversals_hypercube::Relevant_Traversals_hypercube(int i, int j, int t
     for (vector<Tuple*>* rel_trav : relevant_traversals ) {
         hash_table_dimension = rel_trav->size()*K_matrix;
 		
-		hash_tables[rel_indx] = new Hash_Table_Hypercube(table_size_hypercube, hash_table_dimension, w, k);
+		hash_tables[rel_indx] = new Hash_Table_Hypercube(table_size_hypercube, hash_table_dimension, w, k, M, m);
 		rel_indx++;
-
-        vector<unsigned> *m_powers = new vector<unsigned>;
-        for (size_t i = 0; i < hash_table_dimension; i++) {
-            m_powers->push_back( pow_mod(m, i, M) );
-        }
-        m_powers_array.push_back(m_powers);
     }
 
     this->length_i = i;
@@ -36,15 +30,13 @@ Relevant_Traversals_hypercube::~Relevant_Traversals_hypercube() {
 		}
 		delete relevant_traversal;
 		delete hash_tables[i];
-		delete m_powers_array[i];
 		i++;
 	}
 	delete[] hash_tables;
 }
 
-void Relevant_Traversals_hypercube::insert(Curve *curve, int w,
-    int k, int bits_of_each_hash, int M,
-    double **G_matrix, int K_matrix, int curve_dimension) {
+void Relevant_Traversals_hypercube::insert(Curve *curve, double **G_matrix, int K_matrix,
+    int curve_dimension) {
 
 	Item *item = NULL;
 	unsigned P_value;
@@ -53,10 +45,16 @@ void Relevant_Traversals_hypercube::insert(Curve *curve, int w,
 		convert_2d_curve_to_vector_by_projection(*relevant_traversal, 0, G_matrix,
 		curve, K_matrix, curve_dimension, &item);
 
-		P_value = hash_tables[rel_indx]->p(*(item->get_coordinates()),hash_tables[rel_indx]->get_dimension(), table_size_hypercube, w,  k, bits_of_each_hash,  M, *m_powers_array[rel_indx]);
-		hash_tables[rel_indx]->insert(curve, P_value);
+		P_value = hash_tables[rel_indx]->p(item->get_coordinates()->data());
+		hash_tables[rel_indx]->insert(curve->get_id(), P_value);
 		delete item;
 		rel_indx++;
 
 	}
 }
+
+void Relevant_Traversals_hypercube::freeze() {
+	for (size_t i = 0; i < relevant_traversals.size(); i++) {
+		hash_tables[i]->freeze();
+	}
+}
@@ -0,0 +1,484 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <list>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <malloc.h>
+
+using namespace std;
+
+#include "../item/item.hpp"
+#include "../point/point.hpp"
+#include "../curve/curve.hpp"
+#include "../dataset/dataset.hpp"
+#include "../query_result/query_result.hpp"
+#include "../knn_heap/knn_heap.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../exact_search/exact_search.hpp"
+#include "../ground_truth/ground_truth.hpp"
+#include "../latency_histogram/latency_histogram.hpp"
+#include "../helping_functions/helping_functions.hpp"
+#include "../lsh/lsh.hpp"
+#include "../hypercube/hypercube.hpp"
+#include "../curve_grid_lsh/curve_grid_lsh.hpp"
+#include "../curve_projection_lsh/curve_projection_lsh.hpp"
+#include "../curve_grid_hypercube/curve_grid_hypercube.hpp"
+#include "../curve_projection_hypercube/curve_projection_hypercube.hpp"
+
+#define NEIGHBOURS_DEFAULT 10
+#define THREADS_DEFAULT 1
+#define CURVE_DIMENSION_DEFAULT 2
+#define EPS_DEFAULT 0.5
+#define M_TABLE_DEFAULT 6
+//k of the g functions of the cubes, as in the cube mains
+#define CUBE_K_DEFAULT 4
+
+//the kinds of index a sweep can build
+#define VECTOR_LSH 0
+#define VECTOR_CUBE 1
+#define GRID_LSH 2
+#define GRID_CUBE 3
+#define PROJECTION_LSH 4
+#define PROJECTION_CUBE 5
+
+static const char *index_names[] = {"lsh", "cube", "grid_lsh", "grid_cube", "projection_lsh", "projection_cube"};
+
+//one point of the grid. The cubes read k as the dimension of the cube and threshold
+//as M, the number of items a query may check. L is the number of cubes of the vector cube.
+struct Sweep_Setting {
+	int L;
+	int k;
+	int w;
+	int threshold;
+	int probes;
+};
+
+struct Sweep_Result {
+	Sweep_Setting setting;
+	double recall_1;
+	double recall_n;
+	double average_af;
+	double max_af;
+	double p50; //wall seconds per query
+	double p99;
+	double build_time;
+	size_t memory; //bytes the build left allocated
+};
+
+//bytes allocated by malloc, in the arena and in its own mappings
+static size_t heap_bytes() {
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+}
+
+//"5,10,20" -> 5 10 20
+static bool parse_list(const char *text, vector<int>& values) {
+	values.clear();
+	while (*text != '\0') {
+		char *end;
+		long value = strtol(text, &end, 10);
+		if (end == text) {
+			return false;
+		}
+		values.push_back(value);
+		text = *end == ',' ? end + 1 : end;
+	}
+	return values.empty() == false;
+}
+
+//answers every query with ann and kann and compares them with the exact neighbours.
+//The latencies are those ann measured, hits and empty searches alike
+static void evaluate(uint32_t num_of_queries, int num_of_neighbours, vector<Query_Result>& exact_results,
+		vector<KNN_Heap>& exact_neighbours, const function<void(uint32_t, Query_Result&)>& ann,
+		const function<void(uint32_t, KNN_Heap&)>& kann, Thread_Pool& thread_pool, Sweep_Result& result) {
+	vector<Query_Result> ann_results(num_of_queries);
+	vector<double> recalls(num_of_queries);
+	Latency_Histogram latencies;
+
+	thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+		ann(query_id, ann_results[query_id]);
+		latencies.record(ann_results[query_id].get_latency());
+
+		KNN_Heap approximate(num_of_neighbours);
+		kann(query_id, approximate);
+		recalls[query_id] = recall(approximate, exact_neighbours[query_id]);
+	});
+
+	int found_nearest = 0;
+	int not_null = 0;
+	double sum_rate = 0;
+	double sum_recall = 0;
+	result.max_af = -1;
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		Query_Result& ann_result = ann_results[query_id];
+		Query_Result& exact_result = exact_results[query_id];
+		sum_recall += recalls[query_id];
+		if (ann_result.get_time() == -1) {
+			continue;
+		}
+		not_null++;
+		if (exact_result.get_best_distance() != 0) { //division by zero
+			double rate = ann_result.get_best_distance()/exact_result.get_best_distance();
+			result.max_af = max(result.max_af, rate);
+			sum_rate += rate;
+		}
+		if (ann_result.get_name() == exact_result.get_name()) {
+			found_nearest++;
+		}
+	}
+	result.recall_1 = (double)found_nearest/num_of_queries;
+	result.recall_n = sum_recall/num_of_queries;
+	result.average_af = not_null > 0 ? sum_rate/not_null : -1;
+	result.p50 = latencies.percentile(0.5);
+	result.p99 = latencies.percentile(0.99);
+}
+
+static void print_header(int num_of_neighbours) {
+	printf("%6s %6s %8s %8s %6s %9s %9s %8s %8s %10s %10s %10s %9s\n", "L", "k", "w", "st", "probes",
+		"recall@1", ("recall@" + to_string(num_of_neighbours)).c_str(), "avg AF", "max AF",
+		"p50 ms", "p99 ms", "memory MB", "build s");
+}
+
+static void print_result(Sweep_Result& result) {
+	Sweep_Setting& setting = result.setting;
+	printf("%6d %6d %8d %8d %6d %9.3f %9.3f %8.3f %8.3f %10.4f %10.4f %10.2f %9.3f\n", setting.L, setting.k,
+		setting.w, setting.threshold, setting.probes, result.recall_1, result.recall_n, result.average_af,
+		result.max_af, result.p50*1e3, result.p99*1e3, result.memory/1048576.0, result.build_time);
+	fflush(stdout);
+}
+
+//the settings no other setting beats on both recall@n and p50 latency, fastest first
+static void pareto_frontier(vector<Sweep_Result>& results, vector<Sweep_Result>& frontier) {
+	vector<Sweep_Result> sorted(results);
+	sort(sorted.begin(), sorted.end(), [](const Sweep_Result& result1, const Sweep_Result& result2) {
+		if (result1.p50 != result2.p50) {
+			return result1.p50 < result2.p50;
+		}
+		return result1.recall_n > result2.recall_n;
+	});
+	double best_recall = 0;
+	for (Sweep_Result& result : sorted) {
+		if (result.recall_n > best_recall) {
+			frontier.push_back(result);
+			best_recall = result.recall_n;
+		}
+	}
+}
+
+int main(int argc, char *argv[]) {
+	string kind_name = "", input_file = "", query_file = "", ground_truth_file = "";
+	int num_of_neighbours = NEIGHBOURS_DEFAULT;
+	int threads = THREADS_DEFAULT;
+	double eps = EPS_DEFAULT;
+	int M_table = M_TABLE_DEFAULT;
+	float delta = -1;
+	vector<int> Ls, ks, ws, thresholds, probes;
+
+	//READ COMMAND LINE ARGUMENTS
+	bool valid = true;
+	for (int i = 1; i < argc && valid; i++) {
+		if (i + 1 >= argc) {
+			valid = false;
+		}
+		else if (strcmp(argv[i], "-index") == 0) {
+			kind_name = argv[++i];
+		}
+		else if (strcmp(argv[i], "-d") == 0) {
+			input_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-q") == 0) {
+			query_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-gt") == 0) {
+			ground_truth_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-L") == 0) {
+			valid = parse_list(argv[++i], Ls);
+		}
+		else if (strcmp(argv[i], "-k") == 0) {
+			valid = parse_list(argv[++i], ks);
+		}
+		else if (strcmp(argv[i], "-w") == 0) {
+			valid = parse_list(argv[++i], ws);
+		}
+		else if (strcmp(argv[i], "-st") == 0) {
+			valid = parse_list(argv[++i], thresholds);
+		}
+		else if (strcmp(argv[i], "-probes") == 0) {
+			valid = parse_list(argv[++i], probes);
+		}
+		else if (strcmp(argv[i], "-neighbours") == 0) {
+			num_of_neighbours = max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-threads") == 0) {
+			threads = max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-e") == 0) {
+			eps = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-M_table") == 0) {
+			M_table = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-delta") == 0) {
+			delta = atof(argv[++i]);
+		}
+		else {
+			valid = false;
+		}
+	}
+	int kind = -1;
+	for (int i = 0; i < 6; i++) {
+		if (kind_name == index_names[i]) {
+			kind = i;
+		}
+	}
+	if (valid == false || kind == -1 || input_file == "" || query_file == "") {
+		cout <<"usage: ./sweep -index <lsh|cube|grid_lsh|grid_cube|projection_lsh|projection_cube>"
+			<<" -d <input file> -q <query file> [-gt <ground truth file>] [-L <list>] [-k <list>]"
+			<<" [-w <list>] [-st <list>] [-probes <list>] [-neighbours <int>] [-threads <int>]"
+			<<" [-e <double>] [-M_table <int>] [-delta <double>]"<<endl;
+		cout <<"lists are comma separated, like -w 2000,4000,8000. For the cubes -k is the dimension"
+			<<" of the cube and -st is M"<<endl;
+		return 1;
+	}
+	bool curves = kind >= GRID_LSH;
+	bool projection = kind == PROJECTION_LSH || kind == PROJECTION_CUBE;
+	bool cube = kind == VECTOR_CUBE || kind == GRID_CUBE || kind == PROJECTION_CUBE;
+
+	//READ THE DATA ONCE
+	Dataset<Type> input_items, queries;
+	list<Curve*> input_curves, query_list;
+	//the grid vectors are sized and padded from the input curves only, as in the mains
+	int max_curve_length = 0, query_max_curve_length = 0;
+	double max_coord = 0, query_max_coord = 0;
+	uint32_t num_of_items, num_of_queries;
+	if (curves == false) {
+		read_vectors_from_file(input_file, input_items);
+		read_vectors_from_file(query_file, queries);
+		num_of_items = input_items.get_size();
+		num_of_queries = queries.get_size();
+	}
+	else if (projection) {
+		read_2d_curves_from_file(input_file, input_curves, max_curve_length, M_table);
+		read_2d_curves_from_file(query_file, query_list, query_max_curve_length, M_table);
+		num_of_items = input_curves.size();
+		num_of_queries = query_list.size();
+	}
+	else {
+		read_2d_curves_from_file(input_file, input_curves, max_curve_length, max_coord);
+		query_max_coord = max_coord;
+		read_2d_curves_from_file(query_file, query_list, query_max_curve_length, query_max_coord);
+		num_of_items = input_curves.size();
+		num_of_queries = query_list.size();
+	}
+	if (num_of_items == 0 || num_of_queries == 0) {
+		cout <<"No items in the input or the query file"<<endl;
+		return 1;
+	}
+	vector<Curve*> curves_by_id(input_curves.begin(), input_curves.end());
+	vector<Curve*> query_curves(query_list.begin(), query_list.end());
+
+	//THE DEFAULTS OF THE MAINS FOR THE PARAMETERS NOT SWEPT
+	int log_n = max(1, (int)log2(num_of_items));
+	int default_threshold = max((int)num_of_items/10, 500);
+	const int default_ws[] = {4300, 4000, 40, 1, 1, 1};
+	const int default_thresholds[] = {default_threshold, 5000, default_threshold, 500, default_threshold, 500};
+	const int default_probes[] = {0, 14, 0, 14, 0, 2};
+	if (Ls.empty()) {
+		Ls.push_back(kind == VECTOR_CUBE ? 1 : 5);
+	}
+	if (ks.empty()) {
+		ks.push_back(cube ? log_n : 4);
+	}
+	if (ws.empty()) {
+		ws.push_back(default_ws[kind]);
+	}
+	if (thresholds.empty()) {
+		thresholds.push_back(default_thresholds[kind]);
+	}
+	if (probes.empty()) {
+		probes.push_back(default_probes[kind]);
+	}
+	unsigned m = numeric_limits<unsigned>::max() + 1 - 5;
+	int hash_table_dimension = CURVE_DIMENSION_DEFAULT*max_curve_length;
+	int K_matrix = 0 - CURVE_DIMENSION_DEFAULT*log2(eps)/(eps*eps);
+	if (kind == GRID_LSH || kind == GRID_CUBE) {
+		if (delta == -1) {
+			delta = calculate_delta(input_curves);
+		}
+		cout <<"delta: "<<delta<<endl;
+	}
+
+	//THE EXACT NEIGHBOURS ONCE, FROM THE GROUND TRUTH FILE WHEN IT HAS THEM
+	vector<KNN_Heap> exact_neighbours(num_of_queries, KNN_Heap(num_of_neighbours));
+	vector<double> exact_times(num_of_queries);
+	vector<Query_Result> exact_results(num_of_queries);
+	Thread_Pool exact_thread_pool(max(1u, thread::hardware_concurrency()));
+	double time = get_wall_time();
+	get_ground_truth(ground_truth_file, input_file, query_file, projection ? M_table : 0,
+			curves ? input_curves.size() : input_items.get_size(), exact_neighbours, exact_times, [&] {
+		if (curves == false) {
+			exact_search(&input_items, &queries, exact_neighbours, exact_times, exact_thread_pool);
+			return;
+		}
+		exact_thread_pool.run(num_of_queries, [&](uint32_t query_id) {
+			double time = get_thread_time();
+			exhaustive_curve_search_k(&input_curves, query_curves[query_id], exact_neighbours[query_id]);
+			exact_neighbours[query_id].sort();
+			exact_times[query_id] = get_thread_time() - time;
+		});
+	});
+	for (uint32_t query_id = 0; query_id < num_of_queries; query_id++) {
+		if (curves) {
+			ground_truth_result(exact_neighbours[query_id], exact_times[query_id], curves_by_id,
+				exact_results[query_id]);
+		}
+		else {
+			ground_truth_result(exact_neighbours[query_id], exact_times[query_id], &input_items,
+				exact_results[query_id]);
+		}
+	}
+	cout <<"index: "<<index_names[kind]<<", "<<num_of_items<<" items, "<<num_of_queries<<" queries"<<endl;
+	cout <<"Exact search total time: "<<get_wall_time() - time<<endl<<endl;
+
+	//BUILD AND QUERY AN INDEX FOR EVERY SETTING
+	Thread_Pool thread_pool(threads);
+	vector<Sweep_Result> results;
+	print_header(num_of_neighbours);
+	for (int L : Ls) for (int k : ks) for (int w : ws) for (int threshold : thresholds) for (int probe : probes) {
+		Sweep_Result result;
+		result.setting = {L, k, w, threshold, probe};
+		if (L <= 0 || k <= 0 || w <= 0) {
+			cout <<"skipped L "<<L<<" k "<<k<<" w "<<w<<endl;
+			continue;
+		}
+
+		LSH<Type> *lsh = NULL;
+		Hypercube<Type> *hypercube = NULL;
+		Curve_Grid_LSH *grid_lsh = NULL;
+		Curve_Grid_hypercube *grid_cube = NULL;
+		Curve_Projection_LSH *projection_lsh = NULL;
+		Curve_Projection_hypercube *projection_cube = NULL;
+		list<Curve*> grid_curves;
+
+		size_t memory = heap_bytes();
+		double build_time = get_wall_time();
+		if (kind == VECTOR_LSH) {
+			lsh = new LSH<Type>(L, &input_items, w, k, m);
+			lsh->build(threads);
+		}
+		else if (kind == VECTOR_CUBE) {
+			hypercube = new Hypercube<Type>(L, k, &input_items, w, CUBE_K_DEFAULT, m, threshold);
+			for (uint32_t id = 0; id < num_of_items; id++) {
+				hypercube->insert_item(id);
+			}
+			hypercube->freeze();
+		}
+		else if (kind == GRID_LSH) {
+			grid_lsh = new Curve_Grid_LSH(L, hash_table_dimension, w, k, delta, CURVE_DIMENSION_DEFAULT,
+				m, max_coord);
+			for (Curve *curve : input_curves) {
+				grid_lsh->insert_curve(curve, &grid_curves);
+			}
+			grid_lsh->freeze();
+		}
+		else if (kind == GRID_CUBE) {
+			grid_cube = new Curve_Grid_hypercube(L, hash_table_dimension, w, CUBE_K_DEFAULT, delta,
+				CURVE_DIMENSION_DEFAULT, m, threshold, k, probe, max_coord);
+			for (Curve *curve : input_curves) {
+				grid_cube->insert_curve(curve, &grid_curves);
+			}
+			grid_cube->freeze();
+		}
+		else if (kind == PROJECTION_LSH) {
+			projection_lsh = new Curve_Projection_LSH(L, w, k, CURVE_DIMENSION_DEFAULT, m, M_table, K_matrix);
+			for (Curve *curve : input_curves) {
+				projection_lsh->insert_curve(curve);
+			}
+			projection_lsh->freeze();
+		}
+		else {
+			projection_cube = new Curve_Projection_hypercube(w, CUBE_K_DEFAULT, CURVE_DIMENSION_DEFAULT, m,
+				threshold, K_matrix, k, probe, M_table);
+			for (Curve *curve : input_curves) {
+				projection_cube->insert_curve(curve);
+			}
+			projection_cube->freeze();
+		}
+		result.build_time = get_wall_time() - build_time;
+		result.memory = heap_bytes() - memory;
+
+		evaluate(num_of_queries, num_of_neighbours, exact_results, exact_neighbours,
+			[&](uint32_t query_id, Query_Result& query_result) {
+				if (lsh != NULL) {
+					lsh->ANN(queries.get_coordinates(query_id), threshold, probe, query_result);
+				}
+				else if (hypercube != NULL) {
+					hypercube->ANN(queries.get_coordinates(query_id), probe, query_result);
+				}
+				else if (grid_lsh != NULL) {
+					grid_lsh->ANN(query_curves[query_id], threshold, query_result, false);
+				}
+				else if (grid_cube != NULL) {
+					grid_cube->ANN(query_curves[query_id], probe, query_result, false);
+				}
+				else if (projection_lsh != NULL) {
+					projection_lsh->ANN(query_curves[query_id], threshold, query_result);
+				}
+				else {
+					projection_cube->ANN(query_curves[query_id], probe, query_result);
+				}
+			},
+			[&](uint32_t query_id, KNN_Heap& neighbours) {
+				if (lsh != NULL) {
+					lsh->kANN(queries.get_coordinates(query_id), threshold, probe, neighbours);
+				}
+				else if (hypercube != NULL) {
+					hypercube->kANN(queries.get_coordinates(query_id), probe, neighbours);
+				}
+				else if (grid_lsh != NULL) {
+					grid_lsh->kANN(query_curves[query_id], threshold, neighbours, false);
+				}
+				else if (grid_cube != NULL) {
+					grid_cube->kANN(query_curves[query_id], probe, neighbours, false);
+				}
+				else if (projection_lsh != NULL) {
+					projection_lsh->kANN(query_curves[query_id], threshold, neighbours);
+				}
+				else {
+					projection_cube->kANN(query_curves[query_id], probe, neighbours);
+				}
+			}, thread_pool, result);
+
+		delete lsh;
+		delete hypercube;
+		delete grid_lsh;
+		delete grid_cube;
+		delete projection_lsh;
+		delete projection_cube;
+		delete_curves(grid_curves);
+
+		results.push_back(result);
+		print_result(result);
+	}
+
+	//THE SETTINGS WORTH KEEPING
+	vector<Sweep_Result> frontier;
+	pareto_frontier(results, frontier);
+	cout <<endl<<"Pareto frontier (recall@"<<num_of_neighbours<<" against p50 latency):"<<endl;
+	print_header(num_of_neighbours);
+	for (Sweep_Result& result : frontier) {
+		print_result(result);
+	}
+
+	delete_curves(input_curves);
+	delete_curves(query_list);
+	return 0;
+}
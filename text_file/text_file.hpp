@@ -0,0 +1,69 @@
+#ifndef TEXT_FILE_H
+#define TEXT_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <charconv>
+
+using namespace std;
+
+//a chunk is never smaller than this, so small files are parsed by one thread
+#define TEXT_FILE_MIN_CHUNK (1 << 20)
+
+//a text input file mapped read only, cut at line boundaries into chunks that
+//can be parsed independently. The pointers live as long as the Text_File.
+class Text_File {
+public:
+	Text_File();
+	~Text_File();
+
+	bool open(const string& file_name);
+	void split(int num_of_chunks, vector<const char*>& bounds) const;
+
+	const char* get_begin() const {return data;}
+	const char* get_end() const {return data + size;}
+private:
+	Text_File(const Text_File&);
+	Text_File& operator=(const Text_File&);
+
+	const char *data;
+	size_t size;
+};
+
+//the first character of the next line, end on the last line
+inline const char* next_line(const char *p, const char *end) {
+	const char *newline = (const char*)memchr(p, '\n', end - p);
+	return newline == NULL ? end : newline + 1;
+}
+
+inline const char* skip_spaces(const char *p, const char *end) {
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+		p++;
+	}
+	return p;
+}
+
+//the next whitespace separated word of the line, empty at the end of the line
+inline const char* parse_word(const char *p, const char *end, const char*& word, size_t& length) {
+	p = skip_spaces(p, end);
+	word = p;
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+		p++;
+	}
+	length = p - word;
+	return p;
+}
+
+//the next number of the line, false at the end of the line or on anything else
+template <typename T> bool parse_number(const char*& p, const char *end, T& value) {
+	const char *start = skip_spaces(p, end);
+	from_chars_result result = from_chars(start, end, value);
+	if (result.ec != errc()) {
+		return false;
+	}
+	p = result.ptr;
+	return true;
+}
+
+#endif
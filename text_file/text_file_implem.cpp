@@ -0,0 +1,62 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "text_file.hpp"
+
+Text_File::Text_File() {
+	this->data = NULL;
+	this->size = 0;
+}
+
+Text_File::~Text_File() {
+	if (data != NULL) {
+		munmap((void*)data, size);
+	}
+}
+
+//an empty file opens with no chunks
+bool Text_File::open(const string& file_name) {
+	struct stat info;
+
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	if (fstat(fd, &info) == -1) {
+		close(fd);
+		return false;
+	}
+	if (info.st_size == 0) {
+		close(fd);
+		return true;
+	}
+	void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+	data = (const char*)mapping;
+	size = info.st_size;
+	return true;
+}
+
+//chunk i is [bounds[i], bounds[i + 1]), every chunk but the last ends after a newline
+void Text_File::split(int num_of_chunks, vector<const char*>& bounds) const {
+	const char *end = get_end();
+	size_t chunk = max((size_t)TEXT_FILE_MIN_CHUNK, size/max(num_of_chunks, 1));
+
+	bounds.clear();
+	bounds.push_back(get_begin());
+	for (const char *p = get_begin(); p < end; ) {
+		p = (size_t)(end - p) <= chunk ? end : next_line(p + chunk - 1, end);
+		bounds.push_back(p);
+	}
+}
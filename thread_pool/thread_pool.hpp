@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+//fixed set of worker threads that share a list of tasks. The tasks are handed out one
+//at a time from an atomic counter, so slow queries do not hold back a whole shard.
+class Thread_Pool {
+public:
+	Thread_Pool(int num_of_threads);
+	~Thread_Pool();
+
+	//calls task(i) for every i in [0, num_of_tasks) and returns when all of them are done.
+	//The calling thread works too, so a pool of one thread runs everything in place.
+	void run(uint32_t num_of_tasks, const function<void(uint32_t)>& task);
+	int get_num_of_threads() {return threads.size() + 1;}
+private:
+	Thread_Pool(const Thread_Pool&);
+	Thread_Pool& operator=(const Thread_Pool&);
+
+	void worker();
+	void work();
+
+	vector<thread> threads;
+	mutex lock;
+	condition_variable start;
+	condition_variable done;
+	const function<void(uint32_t)> *task;
+	uint32_t num_of_tasks;
+	atomic<uint32_t> next_task;
+	unsigned generation; //one per run, wakes the workers
+	int busy; //workers still inside the current run
+	bool stop;
+};
+
+#endif
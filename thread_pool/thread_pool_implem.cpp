@@ -0,0 +1,81 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+using namespace std;
+
+#include "thread_pool.hpp"
+
+Thread_Pool::Thread_Pool(int num_of_threads) {
+	this->task = NULL;
+	this->num_of_tasks = 0;
+	this->next_task = 0;
+	this->generation = 0;
+	this->busy = 0;
+	this->stop = false;
+	for (int i = 1; i < num_of_threads; i++) {
+		threads.push_back(thread(&Thread_Pool::worker, this));
+	}
+}
+
+Thread_Pool::~Thread_Pool() {
+	{
+		lock_guard<mutex> guard(lock);
+		stop = true;
+	}
+	start.notify_all();
+	for (thread& t : threads) {
+		t.join();
+	}
+}
+
+void Thread_Pool::run(uint32_t num_of_tasks, const function<void(uint32_t)>& task) {
+	if (num_of_tasks == 0) {
+		return;
+	}
+
+	{
+		lock_guard<mutex> guard(lock);
+		this->task = &task;
+		this->num_of_tasks = num_of_tasks;
+		this->next_task = 0;
+		this->busy = threads.size();
+		this->generation++;
+	}
+	start.notify_all();
+
+	work();
+
+	unique_lock<mutex> guard(lock);
+	done.wait(guard, [this] {return busy == 0;});
+	this->task = NULL;
+}
+
+void Thread_Pool::worker() {
+	unsigned seen = 0;
+	unique_lock<mutex> guard(lock);
+	while (true) {
+		start.wait(guard, [this, seen] {return stop || generation != seen;});
+		if (stop) {
+			return;
+		}
+		seen = generation;
+
+		guard.unlock();
+		work();
+		guard.lock();
+
+		if (--busy == 0) {
+			done.notify_one();
+		}
+	}
+}
+
+void Thread_Pool::work() {
+	for (uint32_t i = next_task++; i < num_of_tasks; i = next_task++) {
+		(*task)(i);
+	}
+}
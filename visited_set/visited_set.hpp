@@ -0,0 +1,33 @@
+#ifndef VISITED_SET_H
+#define VISITED_SET_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+//the items a query has already looked at. Every item keeps the number (epoch) of the
+//last query that saw it, so a new query is one increment and the array is never cleared.
+class Visited_Set {
+public:
+	Visited_Set();
+
+	//starts a new query over the ids [0, size)
+	void start(uint32_t size);
+	//true only the first time an id is seen in the current query
+	bool visit(uint32_t id) {
+		if (stamps[id] == epoch) {
+			return false;
+		}
+		stamps[id] = epoch;
+		return true;
+	}
+private:
+	vector<uint32_t> stamps;
+	uint32_t epoch;
+};
+
+//one set per thread, shared by all the indexes the thread searches
+Visited_Set& get_visited_set();
+
+#endif
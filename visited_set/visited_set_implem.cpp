@@ -0,0 +1,27 @@
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include "visited_set.hpp"
+
+Visited_Set::Visited_Set() {
+	this->epoch = 0;
+}
+
+void Visited_Set::start(uint32_t size) {
+	if (stamps.size() < size) {
+		stamps.resize(size, 0);
+	}
+	epoch++;
+	//after 2^32 queries old stamps could match again
+	if (epoch == 0) {
+		fill(stamps.begin(), stamps.end(), 0);
+		epoch = 1;
+	}
+}
+
+Visited_Set& get_visited_set() {
+	static thread_local Visited_Set visited_set;
+	return visited_set;
+}
@@ -0,0 +1,28 @@
+#ifndef W_ESTIMATOR_H
+#define W_ESTIMATOR_H
+
+#include <list>
+
+#include "../dataset/dataset.hpp"
+#include "../curve/curve.hpp"
+#include "../thread_pool/thread_pool.hpp"
+
+using namespace std;
+
+#define W_SAMPLES_DEFAULT 1000
+
+//mean distance of an item to its nearest neighbour, measured on a random sample,
+//with the 95% confidence interval of the mean
+struct W_Estimate {
+	double mean;
+	double low;
+	double high;
+	int samples;
+};
+
+//the nearest neighbours of the sample come from the whole set, so the cost is
+//samples x size distances instead of size x size
+template <typename T> W_Estimate estimate_w(Dataset<T> *items, int samples, Thread_Pool& thread_pool);
+W_Estimate estimate_curve_w(list<Curve*>& curves, int samples, Thread_Pool& thread_pool);
+
+#endif
@@ -0,0 +1,97 @@
+#include <vector>
+#include <list>
+#include <cmath>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+#include "../helping_functions/helping_functions.hpp"
+#include "../exact_search/exact_search.hpp"
+#include "w_estimator.hpp"
+
+//distinct ids in [0, size), at most samples of them
+static vector<uint32_t> sample_ids(uint32_t size, int samples) {
+	random_device rd;
+	mt19937 generator(rd());
+	vector<uint32_t> ids(size);
+
+	iota(ids.begin(), ids.end(), 0);
+	uint32_t count = min((uint32_t)max(samples, 1), size);
+	for (uint32_t i = 0; i < count; i++) {
+		uniform_int_distribution<uint32_t> pick(i, size - 1);
+		swap(ids[i], ids[pick(generator)]);
+	}
+	ids.resize(count);
+	return ids;
+}
+
+static W_Estimate summarize(vector<double>& distances) {
+	W_Estimate estimate;
+	double n = distances.size();
+	double sum = 0, squares = 0;
+
+	for (double distance : distances) {
+		sum += distance;
+	}
+	estimate.mean = n == 0 ? 0 : sum/n;
+	for (double distance : distances) {
+		squares += (distance - estimate.mean)*(distance - estimate.mean);
+	}
+	double half = n > 1 ? 1.96*sqrt(squares/(n - 1))/sqrt(n) : 0;
+	estimate.low = estimate.mean - half;
+	estimate.high = estimate.mean + half;
+	estimate.samples = n;
+	return estimate;
+}
+
+template <typename T> W_Estimate estimate_w(Dataset<T> *items, int samples, Thread_Pool& thread_pool) {
+	vector<uint32_t> ids = sample_ids(items->get_size(), samples);
+	Dataset<T> sample;
+
+	sample.reserve(ids.size());
+	for (uint32_t id : ids) {
+		sample.insert(items->get_name(id), items->get_coordinates(id), items->get_dimension());
+	}
+
+	//two neighbours, the item itself is one of them
+	vector<KNN_Heap> neighbours(ids.size(), KNN_Heap(2));
+	vector<double> times(ids.size());
+	exact_search(items, &sample, neighbours, times, thread_pool);
+
+	vector<double> distances(ids.size(), 0);
+	for (size_t i = 0; i < ids.size(); i++) {
+		for (int j = 0; j < neighbours[i].get_size(); j++) {
+			if (neighbours[i].get_neighbour(j).id != ids[i]) {
+				distances[i] = neighbours[i].get_neighbour(j).distance;
+				break;
+			}
+		}
+	}
+	return summarize(distances);
+}
+
+template W_Estimate estimate_w(Dataset<double> *items, int samples, Thread_Pool& thread_pool);
+template W_Estimate estimate_w(Dataset<float> *items, int samples, Thread_Pool& thread_pool);
+template W_Estimate estimate_w(Dataset<int16_t> *items, int samples, Thread_Pool& thread_pool);
+template W_Estimate estimate_w(Dataset<uint8_t> *items, int samples, Thread_Pool& thread_pool);
+
+W_Estimate estimate_curve_w(list<Curve*>& curves, int samples, Thread_Pool& thread_pool) {
+	vector<Curve*> curves_by_id(curves.begin(), curves.end());
+	vector<uint32_t> ids = sample_ids(curves_by_id.size(), samples);
+	vector<double> distances(ids.size(), 0);
+
+	thread_pool.run(ids.size(), [&](uint32_t i) {
+		Curve *query = curves_by_id[ids[i]];
+		double best_distance = numeric_limits<double>::max();
+		for (uint32_t id = 0; id < curves_by_id.size(); id++) {
+			if (id != ids[i]) {
+				best_distance = min(best_distance, DTW(query, curves_by_id[id]));
+			}
+		}
+		distances[i] = curves_by_id.size() > 1 ? best_distance : 0;
+	});
+	return summarize(distances);
+}